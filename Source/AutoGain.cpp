@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    AutoGain.cpp
+
+  ==============================================================================
+*/
+
+#include "AutoGain.h"
+
+//==============================================================================
+AutoGain::AutoGain()
+{
+    thread->addTimeSliceClient (this);
+}
+
+AutoGain::~AutoGain()
+{
+    thread->removeTimeSliceClient (this);
+}
+
+void AutoGain::prepare (double newSampleRate, const juce::AudioChannelSet& layout)
+{
+    const juce::ScopedLock sl (meterLock);
+
+    sampleRate = newSampleRate;
+    input.prepare (sampleRate, layout, windowSeconds);
+    output.prepare (sampleRate, layout, windowSeconds);
+    wasEnabled = false;
+}
+
+template <typename SampleType>
+void AutoGain::pushInput (const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    if (enabled.load (std::memory_order_relaxed))
+        input.process (block);
+}
+
+template <typename SampleType>
+void AutoGain::process (const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    auto isEnabled = enabled.load (std::memory_order_relaxed);
+    auto numSamples = (int) block.getNumSamples();
+
+    if (isEnabled)
+        output.process (block);
+
+    auto target = isEnabled ? targetDb.load (std::memory_order_relaxed) : 0.0;
+
+    // at unity and staying there, which is always the case while it's off
+    if (target == currentDb && currentGain == 1.f)
+        return;
+
+    if (sampleRate <= 0.0 || numSamples == 0)
+        return;
+
+    auto maxStep = slewDbPerSecond * numSamples / sampleRate;
+    currentDb += juce::jlimit (-maxStep, maxStep, target - currentDb);
+
+    auto nextGain = juce::Decibels::decibelsToGain ((float) currentDb, -1000.f);
+    // what AudioBuffer::applyGainRamp does, which AudioBlock doesn't have
+    auto increment = (SampleType) (nextGain - currentGain) / (SampleType) numSamples;
+
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+    {
+        auto* data = block.getChannelPointer (ch);
+        auto gain = (SampleType) currentGain;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            data[i] *= gain;
+            gain += increment;
+        }
+    }
+
+    currentGain = nextGain;
+}
+
+template void AutoGain::pushInput (const juce::dsp::AudioBlock<float>&) noexcept;
+template void AutoGain::pushInput (const juce::dsp::AudioBlock<double>&) noexcept;
+template void AutoGain::process (const juce::dsp::AudioBlock<float>&) noexcept;
+template void AutoGain::process (const juce::dsp::AudioBlock<double>&) noexcept;
+
+//==============================================================================
+void AutoGain::update()
+{
+    const juce::ScopedLock sl (meterLock);
+
+    auto isEnabled = enabled.load();
+    auto estimate = estimateDb.load();
+
+    // a new EQ curve makes everything measured so far stale, as does a meter that was stopped
+    auto startOver = (isEnabled && ! wasEnabled) || std::abs (estimate - lastEstimateDb) > 0.01;
+    wasEnabled = isEnabled;
+    lastEstimateDb = estimate;
+
+    input.update();
+    output.update();
+
+    if (startOver)
+    {
+        input.reset();
+        output.reset();
+    }
+
+    auto isMeasured = input.getGatedSeconds() >= settledSeconds && output.getGatedSeconds() >= settledSeconds;
+    auto target = isMeasured ? input.getLoudness() - output.getLoudness() : -estimate;
+
+    targetDb = juce::jlimit (-maxGainDb, maxGainDb, target);
+    measured = isMeasured;
+    inputLoudness = input.getLoudness();
+    outputLoudness = output.getLoudness();
+}
+
+int AutoGain::useTimeSlice()
+{
+    update();
+    return pollIntervalMs;
+}
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    AutoGain.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LoudnessMeter.h"
+
+//==============================================================================
+/**
+    Level compensation that keeps the output as loud as the input, so a boost
+    doesn't win an A/B comparison just by being louder.
+
+    The audio thread feeds a LoudnessMeter before and after the EQ and applies
+    the gain, sliding towards the target at slewDbPerSecond. Everything else -
+    draining the meters, gating their windows and working out the target -
+    runs on a thread shared by all PhaseEQ instances.
+
+    The target is the input loudness minus the output loudness once both meters
+    have settledSeconds of gated audio. Until then, and every time the EQ
+    changes, which starts both windows over, it is the opposite of the static
+    estimate the CoefficientDesigner worked out from the EQ curve.
+*/
+class AutoGain  : private juce::TimeSliceClient
+{
+public:
+    AutoGain();
+    ~AutoGain() override;
+
+    static constexpr double windowSeconds = 10.0;
+    static constexpr double settledSeconds = 3.0;
+    static constexpr double maxGainDb = 24.0;
+    static constexpr double slewDbPerSecond = 12.0;
+
+    /** Call it while the audio thread isn't running. */
+    void prepare (double newSampleRate, const juce::AudioChannelSet& layout);
+
+    /** Audio thread: off, the gain slides back to unity and the meters stop. */
+    void setEnabled (bool shouldBeEnabled) noexcept          { enabled = shouldBeEnabled; }
+
+    /** Audio thread: the static estimate of the current setup, see LoudnessMeter::estimateChange(). */
+    void setEstimate (double changeDb) noexcept              { estimateDb = changeDb; }
+
+    /** Audio thread: meters the input, before the EQ. */
+    template <typename SampleType>
+    void pushInput (const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** Audio thread: meters the output, then applies the gain to it. */
+    template <typename SampleType>
+    void process (const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** Runs the background work right away, for offline renders that can't rely on
+        the thread keeping up. Not for a real-time audio callback. */
+    void update();
+
+    /** Any thread: LUFS, or LoudnessMeter::silence while nothing passes the gates. */
+    double getInputLoudness() const noexcept                 { return inputLoudness.load(); }
+    double getOutputLoudness() const noexcept                { return outputLoudness.load(); }
+
+    /** Any thread: the gain being aimed for, and whether it was measured rather than estimated. */
+    double getTargetDb() const noexcept                      { return targetDb.load(); }
+    bool isMeasured() const noexcept                         { return measured.load(); }
+
+private:
+    struct MeterThread  : public juce::TimeSliceThread
+    {
+        MeterThread() : juce::TimeSliceThread ("PhaseEQ Loudness")     { startThread(); }
+        ~MeterThread() override                                         { stopThread (1000); }
+    };
+
+    int useTimeSlice() override;
+
+    juce::SharedResourcePointer<MeterThread> thread;
+    juce::CriticalSection meterLock;
+    LoudnessMeter input, output;
+    bool wasEnabled = false;
+    double lastEstimateDb = 0.0;
+
+    std::atomic<bool> enabled { false }, measured { false };
+    std::atomic<double> estimateDb { 0.0 }, targetDb { 0.0 };
+    std::atomic<double> inputLoudness { LoudnessMeter::silence }, outputLoudness { LoudnessMeter::silence };
+
+    double sampleRate = 0.0;
+    double currentDb = 0.0;
+    float currentGain = 1.f;
+
+    static constexpr int pollIntervalMs = 50;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutoGain)
+};
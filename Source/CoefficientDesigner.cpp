@@ -0,0 +1,397 @@
+/*
+  ==============================================================================
+
+    CoefficientDesigner.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientDesigner.h"
+#include "LoudnessMeter.h"
+#include "FastFilterDesign.h"
+
+//==============================================================================
+CoefficientDesigner::CoefficientDesigner (juce::AudioProcessorValueTreeState& p)
+    : parameters (p)
+{
+    for (int i = 0; i < ParameterIDs::numBands; ++i)
+    {
+        auto& band = bands[(size_t) i];
+        band.enabled = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::enabled, i));
+        band.type    = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::type, i));
+        band.freq    = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::freq, i));
+        band.gain    = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::gain, i));
+        band.q       = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::q, i));
+        band.channels = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::channels, i));
+        band.routing  = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::routing, i));
+        band.slope    = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::slope, i));
+        band.characteristic = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::characteristic, i));
+        band.dynamic   = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::dynamic, i));
+        band.threshold = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::threshold, i));
+        band.ratio     = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::ratio, i));
+        band.attack    = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::attack, i));
+        band.release   = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::release, i));
+        band.sidechain = parameters.getRawParameterValue (ParameterIDs::band (ParameterIDs::sidechain, i));
+    }
+
+    groupMasks.fill (CascadeSetup::allChannels);
+
+    phaseMode = parameters.getRawParameterValue (ParameterIDs::phaseMode);
+    correctionLow = parameters.getRawParameterValue (ParameterIDs::correctionLow);
+    correctionHigh = parameters.getRawParameterValue (ParameterIDs::correctionHigh);
+    oversampling = parameters.getRawParameterValue (ParameterIDs::oversampling);
+    oversamplingQuality = parameters.getRawParameterValue (ParameterIDs::oversamplingQuality);
+    autoGain = parameters.getRawParameterValue (ParameterIDs::autoGain);
+
+    for (auto* param : parameters.processor.getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (param))
+            parameters.addParameterListener (withID->paramID, this);
+
+    thread->addTimeSliceClient (this);
+}
+
+CoefficientDesigner::~CoefficientDesigner()
+{
+    thread->removeTimeSliceClient (this);
+
+    for (auto* param : parameters.processor.getParameters())
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (param))
+            parameters.removeParameterListener (withID->paramID, this);
+}
+
+void CoefficientDesigner::setSampleRate (double newSampleRate)
+{
+    const juce::ScopedLock sl (designLock);
+
+    // the convolver starts over on every prepare, so it needs a fresh kernel even at the same rate
+    lastKernelRate = 0.0;
+    sampleRate = newSampleRate;
+    triggerUpdate();
+}
+
+void CoefficientDesigner::setChannelLayout (const juce::AudioChannelSet& layout)
+{
+    using Set = juce::AudioChannelSet;
+    std::array<uint64_t, numChannelGroups> masks {};
+    std::array<float, CascadeSetup::maxChannels> weights {};
+    int left = -1, right = -1;
+
+    for (int ch = 0; ch < juce::jmin (layout.size(), CascadeSetup::maxChannels); ++ch)
+    {
+        auto bit = (uint64_t) 1 << ch;
+
+        auto type = layout.getTypeOfChannel (ch);
+        weights[(size_t) ch] = LoudnessMeter::getChannelWeight (type);
+
+        if (type == Set::left && left < 0)     left = ch;
+        if (type == Set::right && right < 0)   right = ch;
+
+        switch (type)
+        {
+            case Set::LFE:
+            case Set::LFE2:
+                masks[lfe] |= bit;
+                continue;
+
+            case Set::left:
+            case Set::right:
+            case Set::centre:
+            case Set::leftCentre:
+            case Set::rightCentre:
+            case Set::wideLeft:
+            case Set::wideRight:
+                masks[front] |= bit;
+                break;
+
+            case Set::leftSurround:
+            case Set::rightSurround:
+            case Set::centreSurround:
+            case Set::leftSurroundSide:
+            case Set::rightSurroundSide:
+            case Set::leftSurroundRear:
+            case Set::rightSurroundRear:
+                masks[surround] |= bit;
+                break;
+
+            case Set::topMiddle:
+            case Set::topFrontLeft:
+            case Set::topFrontCentre:
+            case Set::topFrontRight:
+            case Set::topRearLeft:
+            case Set::topRearCentre:
+            case Set::topRearRight:
+                masks[height] |= bit;
+                break;
+
+            default:
+                // ambisonic and discrete channels only belong to the whole bus
+                break;
+        }
+
+        masks[allButLFE] |= bit;
+    }
+
+    const juce::ScopedLock sl (designLock);
+    groupMasks = masks;
+    loudnessWeights = weights;
+    numChannels = juce::jmin (layout.size(), CascadeSetup::maxChannels);
+    pairLeft = right >= 0 ? left : -1;
+    pairRight = left >= 0 ? right : -1;
+    triggerUpdate();
+}
+
+void CoefficientDesigner::setHostInfoCallback (std::function<void()> callback)
+{
+    const juce::ScopedLock sl (designLock);
+    onHostInfoChanged = std::move (callback);
+}
+
+void CoefficientDesigner::designIfNeeded()
+{
+    if (! needsUpdate.load())
+        return;
+
+    const juce::ScopedLock sl (designLock);
+
+    auto rate = sampleRate.load();
+
+    if (rate <= 0.0 || ! needsUpdate.exchange (false))
+        return;
+
+    auto& setup = audioCoefficients.getWriteBuffer();
+    setup.clear();
+    auto mode = (int) phaseMode->load();
+    setup.linearPhase = mode == linearPhase;
+
+    // the FIR is built from the magnitude response, so linear phase never needs oversampling
+    setup.oversamplingOrder = setup.linearPhase ? 0 : (int) oversampling->load();
+    setup.oversamplingQuality = (int) oversamplingQuality->load();
+    setup.sampleRate = rate * (1 << setup.oversamplingOrder);
+
+    auto hasPair = pairLeft >= 0 && ! setup.linearPhase;
+
+    auto getRouting = [&] (const BandParameters& band)
+    {
+        return hasPair ? (int) band.routing->load() : (int) stereo;
+    };
+
+    auto addBand = [&] (int i)
+    {
+        auto& band = bands[(size_t) i];
+        auto routing = getRouting (band);
+
+        // mid runs where left was and side where right was, see CascadeSetup::midSide
+        auto mask = routing == leftOnly || routing == mid   ? (uint64_t) 1 << pairLeft
+                  : routing == rightOnly || routing == side ? (uint64_t) 1 << pairRight
+                  : groupMasks[(size_t) juce::jlimit (0, numChannelGroups - 1, (int) band.channels->load())];
+
+        auto type = (int) band.type->load();
+        std::array<BiquadCoefficients, slotsPerBand> sections;
+        auto numSections = designSections (band, setup.sampleRate, sections.data());
+
+        for (int s = 0; s < numSections; ++s)
+        {
+            setup.addSection (getBandSlot (i) + s, sections[(size_t) s], mask);
+            setup.midSide[(size_t) (getBandSlot (i) + s)] = routing == mid || routing == side;
+        }
+
+        // the FIR can't follow a level, and without a gain there's nothing to modulate
+        if (setup.linearPhase || band.dynamic->load() < 0.5f || ! FilterDesign::hasGain (type))
+            return;
+
+        auto& dynamicBand = setup.dynamicBands[(size_t) setup.numDynamic++];
+        dynamicBand.slot = getBandSlot (i);
+        dynamicBand.prototype = FilterDesign::makeGainPrototype (type, setup.sampleRate, band.freq->load(), band.q->load());
+        dynamicBand.gainDb = band.gain->load();
+        dynamicBand.thresholdDb = band.threshold->load();
+        dynamicBand.ratio = band.ratio->load();
+        dynamicBand.attack = std::exp (-1.0 / (band.attack->load() * 0.001 * rate));
+        dynamicBand.release = std::exp (-1.0 / (band.release->load() * 0.001 * rate));
+        dynamicBand.sidechain = band.sidechain->load() > 0.5f;
+
+        // shelves listen to everything on their side of the corner, peaks to their band
+        auto detectorType = type == FilterDesign::lowShelf  ? FilterDesign::lowPass
+                          : type == FilterDesign::highShelf ? FilterDesign::highPass
+                                                            : FilterDesign::bandPass;
+        auto detectorQ = type == FilterDesign::peak ? (double) band.q->load() : juce::MathConstants<double>::sqrt2 * 0.5;
+        dynamicBand.detector = FilterDesign::design (detectorType, rate, band.freq->load(), detectorQ, 0.0);
+    };
+
+    // in band order: left or right only doesn't commute with the M/S matrix, so a mid/side
+    // band can't be moved past one
+    for (int i = 0; i < ParameterIDs::numBands; ++i)
+        if (bands[(size_t) i].enabled->load() >= 0.5f)
+            addBand (i);
+
+    setup.midSideLeft = pairLeft;
+    setup.midSideRight = pairRight;
+
+    if (mode == phaseCorrected && setup.numActive > 0)
+    {
+        // the range can't reach past what the host rate can carry
+        auto low = (double) correctionLow->load();
+        auto high = juce::jmin ((double) correctionHigh->load(), rate * 0.45);
+
+        if (low != lastCorrectionLow || high != lastCorrectionHigh || setup.sampleRate != lastCorrectionSetup.sampleRate
+             || ! setup.hasSameSections (lastCorrectionSetup))
+        {
+            correction = cache->getPhaseCorrection (setup, low, high);
+            lastCorrectionSetup = setup;
+            lastCorrectionLow = low;
+            lastCorrectionHigh = high;
+        }
+
+        uint64_t mask = 0;
+        for (int i = 0; i < setup.numActive; ++i)
+            mask |= setup.channelMasks[(size_t) setup.activeSections[(size_t) i]];
+
+        // the same all-pass on both sides of the pair commutes with the M/S matrix,
+        // so it can run in either domain as long as it covers both
+        if (pairLeft >= 0 && (mask & (((uint64_t) 1 << pairLeft) | ((uint64_t) 1 << pairRight))) != 0)
+            mask |= ((uint64_t) 1 << pairLeft) | ((uint64_t) 1 << pairRight);
+
+        for (int i = 0; i < correction->numSections; ++i)
+            setup.addSection (correctionSlot + i, correction->sections[(size_t) i], mask);
+    }
+
+    if (hasPair)
+    {
+        // a section that runs the same on both sides of the pair, or on neither, gives the same
+        // result in either domain; it stays in the one it finds the pair in, so the cascade only
+        // switches between a mid/side band and a left/right only one
+        auto pairMask = ((uint64_t) 1 << pairLeft) | ((uint64_t) 1 << pairRight);
+        auto isNeutral = [&] (int slot)
+        {
+            auto onPair = setup.channelMasks[(size_t) slot] & pairMask;
+            return onPair == 0 || onPair == pairMask;
+        };
+
+        auto inMidSide = false;
+        for (int i = 0; i < setup.numActive; ++i)
+        {
+            if (! isNeutral (setup.activeSections[(size_t) i]))
+            {
+                inMidSide = setup.midSide[(size_t) setup.activeSections[(size_t) i]];
+                break;
+            }
+        }
+
+        for (int i = 0; i < setup.numActive; ++i)
+        {
+            auto slot = (size_t) setup.activeSections[(size_t) i];
+
+            if (isNeutral ((int) slot))
+                setup.midSide[slot] = inMidSide;
+            else
+                inMidSide = setup.midSide[slot];
+        }
+    }
+
+    if (autoGain->load() > 0.5f)
+        setup.loudnessChangeDb = LoudnessMeter::estimateChange (setup, loudnessWeights.data(), numChannels, rate);
+
+    // the kernel goes out first, so it is already waiting when the audio thread switches mode
+    if (setup.linearPhase && (rate != lastKernelRate || ! setup.hasSameSections (lastKernelSetup)))
+    {
+        // the audio thread gets a handle of its own, holding the cache's reference, so its use
+        // count is only this list, the triple buffer and the convolver (see releaseKernels)
+        auto kernel = cache->getLinearPhaseKernel (setup, rate);
+        std::shared_ptr<const ConvolutionKernel> handle (kernel.get(), [kernel] (const ConvolutionKernel*) {});
+
+        publishedKernels.push_back (handle);
+        kernels.push (handle);
+        lastKernelSetup = setup;
+        lastKernelRate = rate;
+    }
+
+    guiCoefficients.push (setup);
+    audioCoefficients.publish();
+
+    auto latency = setup.linearPhase ? PartitionedConvolver::getLatencySamples (rate)
+                                     : Oversampler<float>::getLatencySamples (setup.oversamplingOrder, setup.oversamplingQuality);
+
+    // the sections' rings add up in the worst case; the oversampling filters ring about as long as they delay
+    auto tail = (double) PartitionedConvolver::getKernelLength (rate) / 2;
+
+    if (! setup.linearPhase)
+    {
+        tail = latency;
+
+        for (int i = 0; i < setup.numActive; ++i)
+            tail += FilterDesign::getDecaySamples (setup.sections[(size_t) setup.activeSections[(size_t) i]],
+                                                  tailAttenuationDb, setup.sampleRate * 10.0) / (1 << setup.oversamplingOrder);
+    }
+
+    tailSamples = (int) std::ceil (tail);
+
+    // dragging a frequency changes the tail all the time; hosts only need to hear about big moves
+    auto tailMoved = std::abs (tailSamples - reportedTailSamples) > reportedTailSamples / 4;
+
+    if (tailMoved)
+        reportedTailSamples = tailSamples;
+
+    if ((latencySamples.exchange (latency) != latency || tailMoved) && onHostInfoChanged != nullptr)
+        onHostInfoChanged();
+}
+
+int CoefficientDesigner::designBand (int band, double designRate, BiquadCoefficients* dest) const noexcept
+{
+    if (! juce::isPositiveAndBelow (band, ParameterIDs::numBands) || designRate <= 0.0)
+        return 0;
+
+    auto& b = bands[(size_t) band];
+
+    // the FIR is rebuilt as a whole, and a dynamic band's gain belongs to its detector
+    if (b.enabled->load() < 0.5f || (int) phaseMode->load() == linearPhase
+         || (b.dynamic->load() > 0.5f && FilterDesign::hasGain ((int) b.type->load())))
+        return 0;
+
+    // the same sections as designSections(), from polynomials rather than std::tan, std::sin,
+    // std::cos and std::pow, which this thread can't afford per controller message
+    auto type = (int) b.type->load();
+
+    if (FilterDesign::hasSlope (type))
+        return FastFilterDesign::designSlope (type, (int) b.characteristic->load(), (int) b.slope->load() + 1,
+                                              designRate, b.freq->load(), b.q->load(), dest);
+
+    double freq = b.freq->load(), q = b.q->load(), gain = b.gain->load();
+    FastFilterDesign::design (&type, designRate, &freq, &q, &gain, dest, 1);
+    return 1;
+}
+
+int CoefficientDesigner::designSections (const BandParameters& band, double designRate, BiquadCoefficients* dest) noexcept
+{
+    auto type = (int) band.type->load();
+
+    // the slope is the SLOPE choice plus one, in orders of 6 dB/oct
+    if (FilterDesign::hasSlope (type))
+        return FilterDesign::designSlope (type, (int) band.characteristic->load(), (int) band.slope->load() + 1,
+                                          designRate, band.freq->load(), band.q->load(), dest);
+
+    dest[0] = FilterDesign::design (type, designRate, band.freq->load(), band.q->load(), band.gain->load());
+    return 1;
+}
+
+void CoefficientDesigner::releaseKernels()
+{
+    const juce::ScopedLock sl (designLock);
+
+    // a count of one is this list alone: neither the triple buffer nor the convolver has the
+    // handle, so nothing can take a new reference to it any more
+    publishedKernels.erase (std::remove_if (publishedKernels.begin(), publishedKernels.end(),
+                                            [] (const std::shared_ptr<const ConvolutionKernel>& kernel) { return kernel.use_count() == 1; }),
+                            publishedKernels.end());
+}
+
+int CoefficientDesigner::useTimeSlice()
+{
+    designIfNeeded();
+    releaseKernels();
+    return pollIntervalMs;
+}
+
+void CoefficientDesigner::parameterChanged (const juce::String&, float)
+{
+    // may be called on the audio thread, so only flag the change here
+    triggerUpdate();
+}
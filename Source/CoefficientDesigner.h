@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    CoefficientDesigner.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCascade.h"
+#include "PartitionedConvolver.h"
+#include "Oversampler.h"
+#include "PhaseCorrection.h"
+#include "DesignCache.h"
+#include "ParameterIDs.h"
+#include "TripleBuffer.h"
+
+//==============================================================================
+/**
+    Turns parameter changes into filter coefficients away from the audio thread.
+
+    Parameter listeners only raise a flag. The actual design runs on a thread
+    shared by all PhaseEQ instances in the process (or synchronously through
+    designIfNeeded()) and is handed to the audio thread and the editor through
+    two TripleBuffers, so processBlock never allocates or locks to pick up new
+    coefficients, nor calls any transcendental maths for them. The one design that
+    does run on the audio thread, designBand() for MIDI controllers, uses the
+    polynomial approximations of FastFilterDesign instead.
+
+    Each band owns slotsPerBand slots, enough for its steepest slope, so its
+    sections keep their state whatever the other bands do.
+
+    In linear phase mode the FIR kernel is regenerated here as well, and only
+    when the magnitude response actually changed. In phase corrected mode the
+    all-pass sections that flatten the group delay are refitted the same way,
+    and run in the slots after the bands. Both come from the DesignCache, so
+    instances with the same settings compute them once and share one copy.
+
+    With auto gain on, each setup also carries the static estimate of how much
+    louder it makes things, which covers for the loudness meters while they settle.
+
+    Dynamic bands get everything DynamicBands needs on the audio thread: the
+    detector filter, the envelope poles and the gain independent half of the
+    band's design.
+*/
+class CoefficientDesigner  : private juce::TimeSliceClient,
+                             private juce::AudioProcessorValueTreeState::Listener
+{
+public:
+    explicit CoefficientDesigner (juce::AudioProcessorValueTreeState& parameters);
+    ~CoefficientDesigner() override;
+
+    void setSampleRate (double newSampleRate);
+    double getSampleRate() const noexcept               { return sampleRate.load(); }
+
+    /** Groups a band can be limited to, in the order of the CHANNELS parameter. */
+    enum ChannelGroup
+    {
+        allButLFE = 0,
+        front,
+        surround,
+        height,
+        lfe,
+        numChannelGroups
+    };
+
+    /** In the order of the PHASE_MODE parameter. */
+    enum PhaseMode
+    {
+        minimumPhase = 0,
+        linearPhase,
+        phaseCorrected
+    };
+
+    /** Where a band runs within the stereo pair, in the order of the ROUTING parameter.
+        Anything but stereo needs the layout to have a left and a right channel. */
+    enum Routing
+    {
+        stereo = 0,
+        leftOnly,
+        rightOnly,
+        mid,
+        side
+    };
+
+    /** Works out which channels of the layout belong to each ChannelGroup. */
+    void setChannelLayout (const juce::AudioChannelSet& layout);
+
+    inline void triggerUpdate() noexcept                { needsUpdate = true; }
+
+    /** Runs a design right away if one is pending. Safe from any thread apart from
+        a real-time audio callback, as it may briefly wait for the background thread. */
+    void designIfNeeded();
+
+    static constexpr int slotsPerBand = FilterDesign::maxSlopeSections;
+    static constexpr int correctionSlot = ParameterIDs::numBands * slotsPerBand;
+
+    /** The band's first slot; a slope's sections follow it. */
+    static int getBandSlot (int band) noexcept                    { return band * slotsPerBand; }
+
+    /** Audio thread: the band's sections designed right now from the current parameter
+        values at designRate, for changes that have to land on an exact sample rather
+        than with the next design. Writes up to slotsPerBand sections to dest and returns
+        how many, for the band's slots from getBandSlot() on. They come from
+        FastFilterDesign, within 5e-11 of what the next design publishes. Only bands
+        that run as plain minimum phase sections can be redesigned this way; for the
+        rest it returns 0, and the change arrives with the next design as usual. */
+    int designBand (int band, double designRate, BiquadCoefficients* dest) const noexcept;
+
+    /** Read only by the audio thread. */
+    TripleBuffer<CascadeSetup>& getAudioCoefficients() noexcept   { return audioCoefficients; }
+
+    /** Read only by the audio thread, which hands the kernels on to its
+        PartitionedConvolver. The designer keeps every kernel it published until it sees
+        it is the only one left holding it, so the last reference is always dropped on
+        the designer's side and never frees memory on the audio thread. */
+    TripleBuffer<std::shared_ptr<const ConvolutionKernel>>& getKernels() noexcept     { return kernels; }
+
+    /** Read only by the message thread. */
+    TripleBuffer<CascadeSetup>& getGuiCoefficients() noexcept     { return guiCoefficients; }
+
+    /** Latency implied by the current processing mode. */
+    int getLatencySamples() const noexcept                        { return latencySamples.load(); }
+
+    /** How long, at the host rate and on top of the latency, the output keeps
+        ringing after the input stops, until it has decayed by tailAttenuationDb. */
+    int getTailSamples() const noexcept                           { return tailSamples.load(); }
+
+    static constexpr double tailAttenuationDb = 100.0;
+
+    /** The process wide cache the kernels and corrections come from. */
+    DesignCache& getCache() noexcept                              { return cache.get(); }
+
+    /** The callback runs on whichever thread ran the design, whenever getLatencySamples()
+        changes or getTailSamples() moves far enough to be worth telling the host about. */
+    void setHostInfoCallback (std::function<void()> callback);
+
+private:
+    struct DesignerThread  : public juce::TimeSliceThread
+    {
+        DesignerThread() : juce::TimeSliceThread ("PhaseEQ Designer")   { startThread(); }
+        ~DesignerThread() override                                      { stopThread (1000); }
+    };
+
+    struct BandParameters
+    {
+        std::atomic<float>* enabled = nullptr;
+        std::atomic<float>* type = nullptr;
+        std::atomic<float>* freq = nullptr;
+        std::atomic<float>* gain = nullptr;
+        std::atomic<float>* q = nullptr;
+        std::atomic<float>* channels = nullptr;
+        std::atomic<float>* routing = nullptr;
+        std::atomic<float>* slope = nullptr;
+        std::atomic<float>* characteristic = nullptr;
+        std::atomic<float>* dynamic = nullptr;
+        std::atomic<float>* threshold = nullptr;
+        std::atomic<float>* ratio = nullptr;
+        std::atomic<float>* attack = nullptr;
+        std::atomic<float>* release = nullptr;
+        std::atomic<float>* sidechain = nullptr;
+    };
+
+    /** Every section of a band at designRate, written to dest; returns how many. */
+    static int designSections (const BandParameters& band, double designRate, BiquadCoefficients* dest) noexcept;
+
+    /** Drops the published kernels that nothing else refers to any more. */
+    void releaseKernels();
+
+    int useTimeSlice() override;
+    void parameterChanged (const juce::String& parameterID, float newValue) override;
+
+    juce::AudioProcessorValueTreeState& parameters;
+    juce::SharedResourcePointer<DesignerThread> thread;
+    juce::SharedResourcePointer<DesignCache> cache;
+    juce::CriticalSection designLock;
+    std::array<BandParameters, ParameterIDs::numBands> bands;
+    std::atomic<float>* phaseMode = nullptr;
+    std::atomic<float>* correctionLow = nullptr;
+    std::atomic<float>* correctionHigh = nullptr;
+    std::atomic<float>* oversampling = nullptr;
+    std::atomic<float>* oversamplingQuality = nullptr;
+    std::atomic<float>* autoGain = nullptr;
+
+    std::array<uint64_t, numChannelGroups> groupMasks;
+    int pairLeft = -1, pairRight = -1;
+    std::array<float, CascadeSetup::maxChannels> loudnessWeights {};
+    int numChannels = 0;
+
+    std::atomic<double> sampleRate { 0.0 };
+    std::atomic<bool> needsUpdate { true };
+    std::atomic<int> latencySamples { 0 }, tailSamples { 0 };
+    int reportedTailSamples = 0;
+    std::function<void()> onHostInfoChanged;
+
+    TripleBuffer<CascadeSetup> audioCoefficients, guiCoefficients;
+    TripleBuffer<std::shared_ptr<const ConvolutionKernel>> kernels;
+    std::vector<std::shared_ptr<const ConvolutionKernel>> publishedKernels;
+    CascadeSetup lastKernelSetup;
+    double lastKernelRate = 0.0;
+    std::shared_ptr<const PhaseCorrection> correction;
+    CascadeSetup lastCorrectionSetup;
+    double lastCorrectionLow = 0.0, lastCorrectionHigh = 0.0;
+
+    static_assert (correctionSlot + PhaseCorrection::maxSections <= CascadeSetup::maxSections,
+                   "the correction sections need their own slots");
+
+    static constexpr int pollIntervalMs = 5;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoefficientDesigner)
+};
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    DesignCache.cpp
+
+  ==============================================================================
+*/
+
+#include "DesignCache.h"
+
+//==============================================================================
+std::shared_ptr<const PhaseCorrection> DesignCache::getPhaseCorrection (const CascadeSetup& setup, double lowFrequency, double highFrequency)
+{
+    // the fit works at the setup's own rate, which may be oversampled
+    auto key = makeKey (phaseCorrection, setup, { setup.sampleRate, lowFrequency, highFrequency });
+
+    auto value = findOrCreate (key, [&] (size_t& numBytes)
+    {
+        auto correction = std::make_shared<PhaseCorrection>();
+        makePhaseCorrection (setup, lowFrequency, highFrequency, *correction);
+        numBytes = sizeof (PhaseCorrection);
+        return std::shared_ptr<const void> (std::move (correction));
+    });
+
+    return std::static_pointer_cast<const PhaseCorrection> (value);
+}
+
+std::shared_ptr<const ConvolutionKernel> DesignCache::getLinearPhaseKernel (const CascadeSetup& setup, double sampleRate)
+{
+    auto key = makeKey (linearPhaseKernel, setup, { sampleRate });
+
+    auto value = findOrCreate (key, [&] (size_t& numBytes)
+    {
+        auto kernel = std::make_shared<ConvolutionKernel>();
+        makeLinearPhaseKernel (setup, sampleRate, *kernel);
+        kernel->spectra.shrink_to_fit();
+        numBytes = sizeof (ConvolutionKernel) + kernel->spectra.capacity() * sizeof (std::complex<float>);
+        return std::shared_ptr<const void> (std::move (kernel));
+    });
+
+    return std::static_pointer_cast<const ConvolutionKernel> (value);
+}
+
+DesignCache::Stats DesignCache::getStats() const
+{
+    const juce::ScopedLock sl (lock);
+    return stats;
+}
+
+juce::String DesignCache::Stats::toString() const
+{
+    return "shared designs " + juce::String (numEntries)
+         + " (" + juce::String ((double) numBytes / 1024.0, 1) + " KB)"
+         + "  hits " + juce::String (numHits) + "/" + juce::String (numHits + numMisses)
+         + "  evicted " + juce::String (numEvictions);
+}
+
+//==============================================================================
+DesignCache::Key DesignCache::makeKey (Kind kind, const CascadeSetup& setup, std::initializer_list<double> extra)
+{
+    Key key;
+    key.reserve (1 + extra.size() + (size_t) setup.numActive * 5);
+    key.push_back ((double) kind);
+    key.insert (key.end(), extra.begin(), extra.end());
+
+    // the slots and channels don't change either design, only the coefficients and their order
+    for (int i = 0; i < setup.numActive; ++i)
+    {
+        auto& c = setup.sections[(size_t) setup.activeSections[(size_t) i]];
+        key.insert (key.end(), { c.b0, c.b1, c.b2, c.a1, c.a2 });
+    }
+
+    return key;
+}
+
+std::shared_ptr<const void> DesignCache::findOrCreate (const Key& key, const std::function<std::shared_ptr<const void> (size_t&)>& create)
+{
+    {
+        const juce::ScopedLock sl (lock);
+        auto found = entries.find (key);
+
+        if (found != entries.end())
+        {
+            found->second.lastUsed = ++useCount;
+            ++stats.numHits;
+            return found->second.value;
+        }
+
+        ++stats.numMisses;
+    }
+
+    size_t numBytes = 0;
+    auto value = create (numBytes);
+
+    const juce::ScopedLock sl (lock);
+    auto inserted = entries.insert ({ key, Entry { value, numBytes, ++useCount } });
+
+    // someone else got there first while this one was designing
+    if (! inserted.second)
+        return inserted.first->second.value;
+
+    ++stats.numEntries;
+    stats.numBytes += numBytes;
+    evictUnused();
+
+    return value;
+}
+
+void DesignCache::evictUnused()
+{
+    if (stats.numBytes <= maxBytes && stats.numEntries <= maxEntries)
+        return;
+
+    // only the cache holds these, so dropping them actually gives the memory back
+    std::vector<std::map<Key, Entry>::iterator> unused;
+
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+        if (it->second.value.use_count() == 1)
+            unused.push_back (it);
+
+    std::sort (unused.begin(), unused.end(), [] (const auto& a, const auto& b)
+    {
+        return a->second.lastUsed < b->second.lastUsed;
+    });
+
+    for (auto& it : unused)
+    {
+        if (stats.numBytes <= maxBytes * 3 / 4 && stats.numEntries <= maxEntries * 3 / 4)
+            break;
+
+        stats.numBytes -= it->second.numBytes;
+        --stats.numEntries;
+        ++stats.numEvictions;
+        entries.erase (it);
+    }
+}
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    DesignCache.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCascade.h"
+#include "PartitionedConvolver.h"
+#include "PhaseCorrection.h"
+
+//==============================================================================
+/**
+    The expensive designs, shared by all PhaseEQ instances in the process.
+
+    A session that loads the same preset into many instances would otherwise
+    fit the same phase correction and build the same linear phase kernel once
+    per instance, and keep copies of every kernel in each one. Here a design is
+    looked up by everything it depends on: the rate, the correction range and
+    the coefficients of every active section, which the bands' type, frequency,
+    Q, gain and slope fully determine. Only the first instance to ask computes
+    it. The result is immutable and handed out by shared_ptr, so it lives as
+    long as anything still uses it, whether or not it is still in the cache.
+
+    Once the entries take more than maxBytes, or there are more than maxEntries,
+    the least recently used ones that no instance holds any more are dropped
+    until they fit in three quarters of that, so a stream of knob moves doesn't
+    evict on every design.
+
+    Designs run outside the lock, so two instances asking for the same new one
+    at once may both compute it; the first one stored wins. Lookups lock and
+    may allocate: they belong on the designer's threads, never the audio thread.
+*/
+class DesignCache
+{
+public:
+    DesignCache() = default;
+
+    static constexpr size_t maxBytes = 32 * 1024 * 1024;
+    static constexpr int maxEntries = 256;
+
+    /** What makePhaseCorrection() fits to the setup between the two frequencies. */
+    std::shared_ptr<const PhaseCorrection> getPhaseCorrection (const CascadeSetup& setup, double lowFrequency, double highFrequency);
+
+    /** What makeLinearPhaseKernel() builds from the setup at sampleRate. */
+    std::shared_ptr<const ConvolutionKernel> getLinearPhaseKernel (const CascadeSetup& setup, double sampleRate);
+
+    struct Stats
+    {
+        int numEntries = 0;
+        size_t numBytes = 0;            // what the entries hold, shared or not
+        juce::uint64 numHits = 0, numMisses = 0, numEvictions = 0;
+
+        /** One line summary, for the editor overlay and the tools. */
+        juce::String toString() const;
+    };
+
+    /** Any thread but the audio thread. */
+    Stats getStats() const;
+
+private:
+    enum Kind
+    {
+        phaseCorrection = 0,
+        linearPhaseKernel
+    };
+
+    /** The kind, the extra values, then every active section's coefficients in order. */
+    using Key = std::vector<double>;
+
+    struct Entry
+    {
+        std::shared_ptr<const void> value;
+        size_t numBytes = 0;
+        juce::uint64 lastUsed = 0;
+    };
+
+    static Key makeKey (Kind kind, const CascadeSetup& setup, std::initializer_list<double> extra);
+
+    /** The entry's value, or what create() returns after storing it with its size in bytes. */
+    std::shared_ptr<const void> findOrCreate (const Key& key, const std::function<std::shared_ptr<const void> (size_t&)>& create);
+
+    /** Called with the lock held. */
+    void evictUnused();
+
+    juce::CriticalSection lock;
+    std::map<Key, Entry> entries;
+    juce::uint64 useCount = 0;
+    Stats stats;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DesignCache)
+};
@@ -0,0 +1,158 @@
+/*
+  ==============================================================================
+
+    DynamicBands.cpp
+
+  ==============================================================================
+*/
+
+#include "DynamicBands.h"
+#include "FastFilterDesign.h"
+
+//==============================================================================
+namespace
+{
+    template <typename SampleType>
+    void mixToMono (const juce::dsp::AudioBlock<SampleType>& block, size_t start, size_t numSamples, double* dest) noexcept
+    {
+        std::fill (dest, dest + numSamples, 0.0);
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        {
+            auto* src = block.getChannelPointer (ch) + start;
+            for (size_t n = 0; n < numSamples; ++n)
+                dest[n] += (double) src[n];
+        }
+
+        auto scale = 1.0 / (double) juce::jmax ((size_t) 1, block.getNumChannels());
+        for (size_t n = 0; n < numSamples; ++n)
+            dest[n] *= scale;
+    }
+}
+
+//==============================================================================
+void DynamicBands::reset() noexcept
+{
+    for (auto& d : detectors)
+        d.s1 = d.s2 = d.envelope = 0.0;
+}
+
+template <typename SampleType>
+void DynamicBands::setSetup (const CascadeSetup& setup, FilterCascade<SampleType>& cascade, int rampLength) noexcept
+{
+    std::array<bool, CascadeSetup::maxSections> wasDynamic = isDynamic;
+    std::array<int, CascadeSetup::maxSections> reduced;
+    int numReduced = 0;
+
+    isDynamic.fill (false);
+    numBands = setup.numDynamic;
+
+    for (int i = 0; i < numBands; ++i)
+    {
+        auto& band = setup.dynamicBands[(size_t) i];
+        auto& d = detectors[(size_t) band.slot];
+
+        if (! wasDynamic[(size_t) band.slot])
+            d = {};
+        else if (d.reductionDb != 0.0)
+            reduced[(size_t) numReduced++] = i;
+
+        bands[(size_t) i] = band;
+        isDynamic[(size_t) band.slot] = true;
+    }
+
+    applyReductions (reduced.data(), numReduced, cascade, rampLength);
+}
+
+template <typename SampleType>
+void DynamicBands::applyReductions (const int* bandIndices, int numToApply, FilterCascade<SampleType>& cascade, int rampLength) noexcept
+{
+    std::array<FilterDesign::GainPrototype, CascadeSetup::maxSections> prototypes;
+    std::array<double, CascadeSetup::maxSections> gains;
+    std::array<BiquadCoefficients, CascadeSetup::maxSections> designs;
+
+    for (int i = 0; i < numToApply; ++i)
+    {
+        auto& band = bands[(size_t) bandIndices[i]];
+        prototypes[(size_t) i] = band.prototype;
+        gains[(size_t) i] = band.gainDb - detectors[(size_t) band.slot].reductionDb;
+    }
+
+    FastFilterDesign::designWithGain (prototypes.data(), gains.data(), designs.data(), numToApply);
+
+    for (int i = 0; i < numToApply; ++i)
+        cascade.setSectionTarget (bands[(size_t) bandIndices[i]].slot, designs[(size_t) i], rampLength);
+}
+
+template <typename SampleType>
+void DynamicBands::process (const juce::dsp::AudioBlock<SampleType>& input, const juce::dsp::AudioBlock<SampleType>& sidechain,
+                            FilterCascade<SampleType>& cascade, int rampLength) noexcept
+{
+    auto numSamples = input.getNumSamples();
+    auto hasSidechain = sidechain.getNumChannels() > 0 && sidechain.getNumSamples() >= numSamples;
+
+    for (size_t start = 0; start < numSamples; start += monoBlockSize)
+    {
+        auto count = juce::jmin (monoBlockSize, numSamples - start);
+
+        mixToMono (input, start, count, inputMono.data());
+        if (hasSidechain)
+            mixToMono (sidechain, start, count, sidechainMono.data());
+
+        for (int i = 0; i < numBands; ++i)
+        {
+            auto& band = bands[(size_t) i];
+            auto& d = detectors[(size_t) band.slot];
+            auto& c = band.detector;
+            auto* x = band.sidechain && hasSidechain ? sidechainMono.data() : inputMono.data();
+
+            auto s1 = d.s1, s2 = d.s2, envelope = d.envelope;
+
+            for (size_t n = 0; n < count; ++n)
+            {
+                auto y = c.b0 * x[n] + s1;
+                s1 = c.b1 * x[n] - c.a1 * y + s2;
+                s2 = c.b2 * x[n] - c.a2 * y;
+
+                auto level = std::abs (y);
+                auto pole = level > envelope ? band.attack : band.release;
+                envelope = level + pole * (envelope - level);
+            }
+
+            juce::dsp::util::snapToZero (s1);
+            juce::dsp::util::snapToZero (s2);
+            d.s1 = s1;
+            d.s2 = s2;
+            d.envelope = envelope;
+        }
+    }
+
+    std::array<int, CascadeSetup::maxSections> changed;
+    int numChanged = 0;
+
+    for (int i = 0; i < numBands; ++i)
+    {
+        auto& band = bands[(size_t) i];
+        auto& d = detectors[(size_t) band.slot];
+
+        auto over = juce::Decibels::gainToDecibels (d.envelope, -120.0) - band.thresholdDb;
+        auto reduction = juce::jlimit (0.0, maxRangeDb, over * (1.0 - 1.0 / band.ratio));
+
+        // a hundredth of a dB is far below what anyone hears, and saves the redesign
+        if (std::abs (reduction - d.reductionDb) < 0.01)
+            continue;
+
+        d.reductionDb = reduction;
+        changed[(size_t) numChanged++] = i;
+    }
+
+    applyReductions (changed.data(), numChanged, cascade, rampLength);
+}
+
+//==============================================================================
+template void DynamicBands::setSetup (const CascadeSetup&, FilterCascade<float>&, int) noexcept;
+template void DynamicBands::setSetup (const CascadeSetup&, FilterCascade<double>&, int) noexcept;
+template void DynamicBands::process (const juce::dsp::AudioBlock<float>&, const juce::dsp::AudioBlock<float>&,
+                                     FilterCascade<float>&, int) noexcept;
+template void DynamicBands::process (const juce::dsp::AudioBlock<double>&, const juce::dsp::AudioBlock<double>&,
+                                     FilterCascade<double>&, int) noexcept;
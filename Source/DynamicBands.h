@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    DynamicBands.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCascade.h"
+
+//==============================================================================
+/**
+    Level detection for the dynamic bands of a FilterCascade.
+
+    Each dynamic band has a detector of its own: the main input, or the
+    sidechain bus if the band asks for it and the host connected one, is mixed
+    to mono, run through a biquad covering the band's range, rectified and
+    followed by a one pole attack/release envelope. Above the threshold the
+    band's gain is pulled down by (level - threshold) * (1 - 1 / ratio) dB, by
+    at most maxRangeDb.
+
+    Everything that needs transcendental maths beyond that was worked out by the
+    CoefficientDesigner, so once per control block process() only finishes the
+    FilterDesign::GainPrototype of each band for its new gain, all of them in
+    one FastFilterDesign batch, and lets the cascade glide there: halfway
+    through the block, all the way by the next one, since a ramp as short as
+    a control interval still takes the cascade two. Bands whose gain didn't
+    move aren't touched.
+*/
+class DynamicBands
+{
+public:
+    DynamicBands() = default;
+
+    static constexpr double maxRangeDb = 24.0;
+
+    void reset() noexcept;
+
+    /** Audio thread: picks up the dynamic bands of a new setup. Bands that stay
+        dynamic keep their envelopes and their gain reduction, so a parameter change
+        doesn't let go of the band; only bands that were just switched on or made
+        dynamic start from their static gain.
+
+        Call it after FilterCascade::setSetup(), which handed the cascade the bands at
+        their static gain: the ones with a reduction going are moved back to it, over
+        rampLength cascade samples like the rest of the setup. */
+    template <typename SampleType>
+    void setSetup (const CascadeSetup& setup, FilterCascade<SampleType>& cascade, int rampLength) noexcept;
+
+    bool isActive() const noexcept      { return numBands > 0; }
+
+    /** Audio thread: runs the detectors over input, or sidechain when it has any
+        channels, then moves each band's section of the cascade to its new gain
+        over rampLength cascade samples. */
+    template <typename SampleType>
+    void process (const juce::dsp::AudioBlock<SampleType>& input, const juce::dsp::AudioBlock<SampleType>& sidechain,
+                  FilterCascade<SampleType>& cascade, int rampLength) noexcept;
+
+private:
+    struct Detector
+    {
+        double s1 = 0.0, s2 = 0.0, envelope = 0.0;
+        double reductionDb = 0.0;   // below the band's static gain, as last handed to the cascade
+    };
+
+    /** Designs each of the bands at its static gain less the reduction and moves the cascade there. */
+    template <typename SampleType>
+    void applyReductions (const int* bandIndices, int numToApply, FilterCascade<SampleType>& cascade, int rampLength) noexcept;
+
+    static constexpr size_t monoBlockSize = 64;
+
+    std::array<CascadeSetup::DynamicBand, CascadeSetup::maxSections> bands;
+    std::array<Detector, CascadeSetup::maxSections> detectors;   // by slot
+    std::array<bool, CascadeSetup::maxSections> isDynamic {};      // by slot
+    int numBands = 0;
+
+    std::array<double, monoBlockSize> inputMono, sidechainMono;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DynamicBands)
+};
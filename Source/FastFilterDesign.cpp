@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    FastFilterDesign.cpp
+
+  ==============================================================================
+*/
+
+#include "FastFilterDesign.h"
+
+namespace FastFilterDesign
+{
+
+namespace
+{
+    constexpr int chunkSize = 16;
+
+    /** sin and cos of omega in [0, pi] and tan (omega / 2), all from the half angle: Taylor series
+        of sin and cos (x) for x = omega / 2 - pi / 4, to x^13 and x^14, where the truncation error is
+        below 3e-14. With C and S those two, tan (omega / 2) = (C + S) / (C - S), sin (omega) =
+        (C - S) (C + S) and cos (omega) = -2 C S, none of which cancels at either end of the range,
+        where sin (omega) / (1 + cos (omega)) would near Nyquist. */
+    void sinCos (const double* omega, double* sinOmega, double* cosOmega, double* tanHalfOmega, int n) noexcept
+    {
+        constexpr auto quarterPi = juce::MathConstants<double>::pi * 0.25;
+
+        for (int i = 0; i < n; ++i)
+        {
+            auto x = omega[i] * 0.5 - quarterPi;
+            auto x2 = x * x;
+
+            auto sinX = x * (1.0 + x2 * (-1.0 / 6.0 + x2 * (1.0 / 120.0 + x2 * (-1.0 / 5040.0 + x2 * (1.0 / 362880.0
+                          + x2 * (-1.0 / 39916800.0 + x2 * (1.0 / 6227020800.0)))))));
+            auto cosX = 1.0 + x2 * (-0.5 + x2 * (1.0 / 24.0 + x2 * (-1.0 / 720.0 + x2 * (1.0 / 40320.0
+                          + x2 * (-1.0 / 3628800.0 + x2 * (1.0 / 479001600.0 + x2 * (-1.0 / 87178291200.0)))))));
+
+            auto sum = cosX + sinX;
+            auto difference = cosX - sinX;
+
+            sinOmega[i] = sum * difference;
+            cosOmega[i] = -2.0 * sinX * cosX;
+            tanHalfOmega[i] = sum / difference;
+        }
+    }
+
+    /** A = 10^(gain / 40) and its square root: e^(x / 16) from a degree 8 Taylor polynomial,
+        squared three times for sqrt (A) and once more for A. */
+    void amplitudes (const double* gainsDb, double* A, double* sqrtA, int n) noexcept
+    {
+        constexpr auto scale = 2.302585092994046 / 40.0 / 16.0; // ln (10) / 40 / 16
+
+        for (int i = 0; i < n; ++i)
+        {
+            auto x = gainsDb[i] * scale;
+            auto e = 1.0 + x * (1.0 + x * (1.0 / 2.0 + x * (1.0 / 6.0 + x * (1.0 / 24.0 + x * (1.0 / 120.0
+                       + x * (1.0 / 720.0 + x * (1.0 / 5040.0 + x * (1.0 / 40320.0))))))));
+            e *= e;
+            e *= e;
+            e *= e;
+
+            sqrtA[i] = e;
+            A[i] = e * e;
+        }
+    }
+}
+
+void design (const int* types, double sampleRate, const double* frequencies, const double* qs,
+             const double* gainsDb, BiquadCoefficients* dest, int numBands) noexcept
+{
+    jassert (sampleRate > 0.0);
+
+    double omega[chunkSize], sinOmega[chunkSize], cosOmega[chunkSize], tanHalfOmega[chunkSize], A[chunkSize], sqrtA[chunkSize];
+    auto toOmega = juce::MathConstants<double>::twoPi / sampleRate;
+
+    for (int start = 0; start < numBands; start += chunkSize)
+    {
+        auto n = juce::jmin (chunkSize, numBands - start);
+
+        for (int i = 0; i < n; ++i)
+            omega[i] = juce::jlimit (1.0, sampleRate * 0.499, frequencies[start + i]) * toOmega;
+
+        sinCos (omega, sinOmega, cosOmega, tanHalfOmega, n);
+        amplitudes (gainsDb + start, A, sqrtA, n);
+
+        for (int i = 0; i < n; ++i)
+        {
+            auto type = types[start + i];
+            auto q = qs[start + i];
+
+            if (FilterDesign::hasGain (type))
+                dest[start + i] = FilterDesign::designWithAmplitude ({ type, cosOmega[i], sinOmega[i] / q }, A[i], sqrtA[i]);
+            else
+                dest[start + i] = FilterDesign::designFromPrewarp (type, tanHalfOmega[i], q);
+        }
+    }
+}
+
+int designSlope (int type, int characteristic, int order, double sampleRate, double frequency, double q,
+                 BiquadCoefficients* dest) noexcept
+{
+    double omega[FilterDesign::maxSlopeSections], qs[FilterDesign::maxSlopeSections];
+    double sinOmega[FilterDesign::maxSlopeSections], cosOmega[FilterDesign::maxSlopeSections], tanHalfOmega[FilterDesign::maxSlopeSections];
+
+    auto numSections = FilterDesign::getSlopeSections (type, characteristic, order, sampleRate, frequency, q, omega, qs);
+    auto toOmega = juce::MathConstants<double>::twoPi / sampleRate;
+
+    for (int i = 0; i < numSections; ++i)
+        omega[i] *= toOmega;
+
+    sinCos (omega, sinOmega, cosOmega, tanHalfOmega, numSections);
+
+    for (int i = 0; i < numSections; ++i)
+        dest[i] = FilterDesign::designSlopeSection (type, tanHalfOmega[i], qs[i]);
+
+    return numSections;
+}
+
+void designWithGain (const FilterDesign::GainPrototype* prototypes, const double* gainsDb,
+                     BiquadCoefficients* dest, int numBands) noexcept
+{
+    double A[chunkSize], sqrtA[chunkSize];
+
+    for (int start = 0; start < numBands; start += chunkSize)
+    {
+        auto n = juce::jmin (chunkSize, numBands - start);
+        amplitudes (gainsDb + start, A, sqrtA, n);
+
+        for (int i = 0; i < n; ++i)
+            dest[start + i] = FilterDesign::designWithAmplitude (prototypes[start + i], A[i], sqrtA[i]);
+    }
+}
+
+}
@@ -0,0 +1,844 @@
+/*
+  ==============================================================================
+
+    FilterCascade.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterCascade.h"
+
+//==============================================================================
+namespace
+{
+    template <typename SectionType, typename ValueType>
+    SectionType makeStep (const SectionType& from, const SectionType& to, ValueType scale) noexcept
+    {
+        return { (to.b0 - from.b0) * scale, (to.b1 - from.b1) * scale, (to.b2 - from.b2) * scale,
+                 (to.a1 - from.a1) * scale, (to.a2 - from.a2) * scale };
+    }
+
+    template <typename SectionType>
+    void stepTowards (SectionType& current, const SectionType& step, const SectionType& target, int& ticks) noexcept
+    {
+        if (--ticks == 0)
+        {
+            current = target;
+            return;
+        }
+
+        current.b0 = current.b0 + step.b0;
+        current.b1 = current.b1 + step.b1;
+        current.b2 = current.b2 + step.b2;
+        current.a1 = current.a1 + step.a1;
+        current.a2 = current.a2 + step.a2;
+    }
+
+    /** Transposed direct form II through a chain of sections over numSamples. Each
+        sample goes through the whole chain before the next one is read, so the block
+        is loaded and stored once rather than once per section, and with the state in
+        registers the sections' recursions overlap instead of each waiting out its own
+        latency for every sample. The coefficients step every interval samples while
+        any of them has ticks left. Type is float, double or a SIMDRegister of either. */
+    template <int numSections, typename Type, typename SectionType>
+    void runChain (Type* data, size_t numSamples, SectionType* c, const SectionType* const* step, const SectionType* const* target,
+                   int* ticks, size_t interval, Type* const* state) noexcept
+    {
+        Type s1[numSections], s2[numSections];
+
+        for (int k = 0; k < numSections; ++k)
+        {
+            s1[k] = state[k][0];
+            s2[k] = state[k][1];
+        }
+
+        for (size_t start = 0; start < numSamples;)
+        {
+            auto end = numSamples;
+
+            for (int k = 0; k < numSections; ++k)
+            {
+                if (ticks[k] > 0)
+                {
+                    stepTowards (c[k], *step[k], *target[k], ticks[k]);
+                    end = juce::jmin (numSamples, start + interval);
+                }
+            }
+
+            for (auto n = start; n < end; ++n)
+            {
+                auto x = data[n];
+
+                for (int k = 0; k < numSections; ++k)
+                {
+                    auto y = c[k].b0 * x + s1[k];
+                    s1[k] = c[k].b1 * x - c[k].a1 * y + s2[k];
+                    s2[k] = c[k].b2 * x - c[k].a2 * y;
+                    x = y;
+                }
+
+                data[n] = x;
+            }
+
+            start = end;
+        }
+
+        for (int k = 0; k < numSections; ++k)
+        {
+            state[k][0] = s1[k];
+            state[k][1] = s2[k];
+        }
+    }
+
+    /** runChain for a chain length only known at run time. */
+    template <typename Type, typename SectionType>
+    void runChain (int numSections, Type* data, size_t numSamples, SectionType* c, const SectionType* const* step,
+                   const SectionType* const* target, int* ticks, size_t interval, Type* const* state) noexcept
+    {
+        switch (numSections)
+        {
+            case 1:  runChain<1> (data, numSamples, c, step, target, ticks, interval, state); break;
+            case 2:  runChain<2> (data, numSamples, c, step, target, ticks, interval, state); break;
+            case 3:  runChain<3> (data, numSamples, c, step, target, ticks, interval, state); break;
+            case 4:  runChain<4> (data, numSamples, c, step, target, ticks, interval, state); break;
+            case 5:  runChain<5> (data, numSamples, c, step, target, ticks, interval, state); break;
+            case 6:  runChain<6> (data, numSamples, c, step, target, ticks, interval, state); break;
+            case 7:  runChain<7> (data, numSamples, c, step, target, ticks, interval, state); break;
+            case 8:  runChain<8> (data, numSamples, c, step, target, ticks, interval, state); break;
+            default: jassertfalse; break;
+        }
+    }
+
+    /** Float sections with a pole closer to the unit circle than this run in double. In
+        float at 1 - r = 1e-3 the errors of a 30 Hz band at 44.1 kHz are already around
+        -50 dB, and they grow as 1 / (1 - r) ^ 2 from there. */
+    constexpr double minFloatPoleDistance = 1.0e-3;
+
+    /** Only what is actually denormal: juce::dsp::util::snapToZero flushes anything under
+        1e-8, which cuts the tail of a low frequency resonance off at around -110 dB and
+        leaves an error far above the rounding noise in its spectrum. */
+    template <typename Type>
+    void flushDenormals (Type* state) noexcept
+    {
+        for (int i = 0; i < 2; ++i)
+            if (std::abs (state[i]) < std::numeric_limits<Type>::min())
+                state[i] = 0;
+    }
+
+    /** Magnitude of the section's larger pole. */
+    double getPoleRadius (const BiquadCoefficients& c) noexcept
+    {
+        auto discriminant = c.a1 * c.a1 - 4.0 * c.a2;
+
+        if (discriminant < 0)
+            return std::sqrt (c.a2);
+
+        return 0.5 * (std::abs (c.a1) + std::sqrt (discriminant));
+    }
+
+    /** In place left/right to mid/side (halved, so decoding is just a sum and a
+        difference) or back, on two channels stored every stride samples. */
+    template <typename Type>
+    void convertMidSide (Type* left, Type* right, size_t stride, size_t numSamples, bool encode) noexcept
+    {
+        auto scale = encode ? (Type) 0.5 : (Type) 1;
+
+        for (size_t n = 0; n < numSamples * stride; n += stride)
+        {
+            auto a = left[n];
+            auto b = right[n];
+            left[n] = (a + b) * scale;
+            right[n] = (a - b) * scale;
+        }
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void FilterCascade<SampleType>::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    numChannels = (size_t) juce::jmin ((int) spec.numChannels, CascadeSetup::maxChannels);
+    state.allocate ((size_t) CascadeSetup::maxSections * numChannels * 2, true);
+    preciseState.allocate ((size_t) CascadeSetup::maxSections * numChannels * 2, true);
+    preciseBufferSize = (size_t) juce::jmax (1, (int) spec.maximumBlockSize);
+    preciseBuffer.allocate (preciseBufferSize, false);
+
+   #if JUCE_USE_SIMD
+    numGroups = (numChannels + Vec::size() - 1) / Vec::size();
+    maxBlockSize = (size_t) spec.maximumBlockSize;
+
+    auto numSectionVecs = (size_t) CascadeSetup::maxSections * numGroups;
+    auto numStateVecs = numSectionVecs * 2;
+    auto numInterleavedVecs = numGroups * maxBlockSize;
+    auto numVecs = numSectionVecs * 5 * 3 + numStateVecs + numInterleavedVecs;
+
+    vecMemory.allocate (numVecs * sizeof (Vec) + Vec::SIMDRegisterSize, true);
+    auto* base = juce::snapPointerToAlignment (reinterpret_cast<Vec*> (vecMemory.get()), (size_t) Vec::SIMDRegisterSize);
+
+    vecSections = reinterpret_cast<VecSection*> (base);
+    vecSteps = vecSections + numSectionVecs;
+    vecTargets = vecSteps + numSectionVecs;
+    vecState = reinterpret_cast<Vec*> (vecTargets + numSectionVecs);
+    interleaved = vecState + numStateVecs;
+   #endif
+
+    // prepare() may have been called after the setup arrived, so re-apply it to the new layout
+    CascadeSetup current;
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto slot = activeSections[(size_t) i];
+        auto& c = preciseTargets[(size_t) slot];
+        current.addSection (slot, { c.b0, c.b1, c.b2, c.a1, c.a2 }, channelMasks[(size_t) slot]);
+    }
+    numActive = 0;
+   #if JUCE_USE_SIMD
+    activeGroups.fill (0);
+   #endif
+    setSetup (current);
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::reset() noexcept
+{
+    if (state != nullptr)
+        std::fill (state.get(), state.get() + (size_t) CascadeSetup::maxSections * numChannels * 2, SampleType());
+
+    if (preciseState != nullptr)
+        std::fill (preciseState.get(), preciseState.get() + (size_t) CascadeSetup::maxSections * numChannels * 2, 0.0);
+
+   #if JUCE_USE_SIMD
+    if (vecState != nullptr)
+        std::fill (vecState, vecState + (size_t) CascadeSetup::maxSections * numGroups * 2, Vec::expand (0));
+   #endif
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::setSmoothing (int rampLengthSamples, int newControlInterval) noexcept
+{
+    rampLength = juce::jmax (0, rampLengthSamples);
+    controlInterval = (size_t) juce::jmax (1, newControlInterval);
+}
+
+template <typename SampleType>
+int FilterCascade<SampleType>::getNumTicks (int rampLengthSamples) const noexcept
+{
+    if (rampLengthSamples <= 0)
+        return 0;
+
+    // a tick lands at the start of an interval, so a single one would be a jump
+    return juce::jmax (2, (int) (((size_t) rampLengthSamples + controlInterval - 1) / controlInterval));
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::setSetup (const CascadeSetup& newSetup) noexcept
+{
+    // channels each slot ran on before and will run on now; 0 for inactive slots
+    std::array<uint64_t, CascadeSetup::maxSections> wasRunning {}, isRunning {};
+
+    for (int i = 0; i < numActive; ++i)
+        wasRunning[(size_t) activeSections[(size_t) i]] = channelMasks[(size_t) activeSections[(size_t) i]];
+
+    numActive = newSetup.numActive;
+    midSideLeft = newSetup.midSideLeft;
+    midSideRight = newSetup.midSideRight;
+    hasMidSide = false;
+
+    auto numTicks = getNumTicks (rampLength);
+
+    for (int i = 0; i < numActive; ++i)
+    {
+        auto slot = newSetup.activeSections[(size_t) i];
+        auto& c = newSetup.sections[(size_t) slot];
+        auto mask = newSetup.channelMasks[(size_t) slot];
+        Section target { (SampleType) c.b0, (SampleType) c.b1, (SampleType) c.b2, (SampleType) c.a1, (SampleType) c.a2 };
+        PreciseSection preciseTarget { c.b0, c.b1, c.b2, c.a1, c.a2 };
+
+        // only glide sections that were already running; new ones start from cleared state anyway
+        auto isPrecise = needsDoublePrecision (c);
+        auto changedPrecision = wasRunning[(size_t) slot] != 0 ? setPrecision (slot, isPrecise) : false;
+        auto glide = numTicks > 0 && wasRunning[(size_t) slot] != 0 && ! changedPrecision;
+
+        activeSections[(size_t) i] = slot;
+        channelMasks[(size_t) slot] = mask;
+        targets[(size_t) slot] = target;
+        preciseTargets[(size_t) slot] = preciseTarget;
+        precise[(size_t) slot] = isPrecise;
+        midSide[(size_t) slot] = newSetup.midSide[(size_t) slot];
+        hasMidSide = hasMidSide || midSide[(size_t) slot];
+        rampTicks[(size_t) slot] = glide ? numTicks : 0;
+        isRunning[(size_t) slot] = mask;
+
+        if (glide)
+        {
+            steps[(size_t) slot] = makeStep (sections[(size_t) slot], target, (SampleType) 1 / (SampleType) numTicks);
+            preciseSteps[(size_t) slot] = makeStep (preciseSections[(size_t) slot], preciseTarget, 1.0 / numTicks);
+        }
+        else
+        {
+            sections[(size_t) slot] = target;
+            preciseSections[(size_t) slot] = preciseTarget;
+        }
+
+       #if JUCE_USE_SIMD
+        if (vecSections != nullptr)
+        {
+            constexpr auto lanes = Vec::size();
+            auto wasGroups = activeGroups[(size_t) slot];
+            uint64_t groups = 0;
+
+            for (size_t group = 0; group < numGroups; ++group)
+            {
+                auto index = getVecIndex (slot, group);
+                auto groupBit = (uint64_t) 1 << group;
+
+                // identity in the lanes the section doesn't apply to
+                VecSection vecTarget { Vec::expand (1), Vec::expand (0), Vec::expand (0), Vec::expand (0), Vec::expand (0) };
+
+                for (size_t lane = 0; lane < lanes; ++lane)
+                {
+                    auto ch = group * lanes + lane;
+                    if (ch >= numChannels || ((mask >> ch) & 1) == 0)
+                        continue;
+
+                    vecTarget.b0.set (lane, target.b0);
+                    vecTarget.b1.set (lane, target.b1);
+                    vecTarget.b2.set (lane, target.b2);
+                    vecTarget.a1.set (lane, target.a1);
+                    vecTarget.a2.set (lane, target.a2);
+                    groups |= groupBit;
+                }
+
+                vecTargets[index] = vecTarget;
+
+                // lanes joining or leaving a group that keeps running glide from or to the identity
+                if (glide && (groups & wasGroups & groupBit) != 0)
+                {
+                    vecSteps[index] = makeStep (vecSections[index], vecTarget, Vec::expand ((SampleType) 1 / (SampleType) numTicks));
+                    continue;
+                }
+
+                vecSections[index] = vecTarget;
+
+                if ((wasGroups & groupBit) == 0)
+                    continue;
+
+                // no glide: lanes that just left mustn't feed their state through the identity section
+                for (size_t lane = 0; lane < lanes; ++lane)
+                {
+                    auto ch = group * lanes + lane;
+                    if (ch >= numChannels || (((wasRunning[(size_t) slot] & ~mask) >> ch) & 1) == 0)
+                        continue;
+
+                    auto* st = getVecState (slot, group);
+                    st[0].set (lane, 0);
+                    st[1].set (lane, 0);
+                }
+            }
+
+            activeGroups[(size_t) slot] = groups;
+        }
+       #endif
+    }
+
+    updateChains();
+
+    if (state == nullptr)
+        return;
+
+    // a band or channel that comes back should start from silence, not from where it was left
+    for (int slot = 0; slot < CascadeSetup::maxSections; ++slot)
+    {
+        auto removed = wasRunning[(size_t) slot] & ~isRunning[(size_t) slot];
+
+        if (removed == 0)
+            continue;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            if (((removed >> ch) & 1) != 0)
+            {
+                std::fill (getState (slot, ch), getState (slot, ch) + 2, SampleType());
+                std::fill (getPreciseState (slot, ch), getPreciseState (slot, ch) + 2, 0.0);
+            }
+        }
+
+       #if JUCE_USE_SIMD
+        if (isRunning[(size_t) slot] == 0)
+            activeGroups[(size_t) slot] = 0;
+
+        for (size_t group = 0; group < numGroups; ++group)
+            if (((activeGroups[(size_t) slot] >> group) & 1) == 0)
+                std::fill (getVecState (slot, group), getVecState (slot, group) + 2, Vec::expand (0));
+       #endif
+    }
+}
+
+template <typename SampleType>
+bool FilterCascade<SampleType>::needsDoublePrecision (const BiquadCoefficients& c) noexcept
+{
+    return std::is_same<SampleType, float>::value && 1.0 - getPoleRadius (c) < minFloatPoleDistance;
+}
+
+template <typename SampleType>
+bool FilterCascade<SampleType>::setPrecision (int slot, bool shouldBePrecise) noexcept
+{
+    if (precise[(size_t) slot] == shouldBePrecise)
+        return false;
+
+    precise[(size_t) slot] = shouldBePrecise;
+
+    if (state == nullptr)
+        return true;
+
+   #if JUCE_USE_SIMD
+    constexpr auto lanes = Vec::size();
+    auto vectorised = numChannels > 1 && vecState != nullptr;
+   #endif
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* s = getState (slot, ch);
+        auto* p = getPreciseState (slot, ch);
+
+        if (shouldBePrecise)
+        {
+            p[0] = (double) s[0];
+            p[1] = (double) s[1];
+
+           #if JUCE_USE_SIMD
+            if (vectorised)
+            {
+                auto* v = getVecState (slot, ch / lanes);
+                p[0] = (double) v[0].get (ch % lanes);
+                p[1] = (double) v[1].get (ch % lanes);
+            }
+           #endif
+        }
+        else
+        {
+            // whichever loop runs next picks it up
+            s[0] = (SampleType) p[0];
+            s[1] = (SampleType) p[1];
+
+           #if JUCE_USE_SIMD
+            if (vecState != nullptr)
+            {
+                auto* v = getVecState (slot, ch / lanes);
+                v[0].set (ch % lanes, s[0]);
+                v[1].set (ch % lanes, s[1]);
+            }
+           #endif
+        }
+    }
+
+    return true;
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::updateChains() noexcept
+{
+    static_assert (maxChainSections <= 8, "runChain has a case for every length up to eight");
+
+    // a chain never crosses between left/right and mid/side, since the pair is encoded or
+    // decoded in between, nor between precisions
+    for (int i = 0; i < numActive;)
+    {
+        auto mask = channelMasks[(size_t) activeSections[(size_t) i]];
+        auto isPrecise = precise[(size_t) activeSections[(size_t) i]];
+        auto isMidSide = midSide[(size_t) activeSections[(size_t) i]];
+        auto length = 1;
+
+        while (i + length < numActive && length < maxChainSections
+                && channelMasks[(size_t) activeSections[(size_t) (i + length)]] == mask
+                && precise[(size_t) activeSections[(size_t) (i + length)]] == isPrecise
+                && midSide[(size_t) activeSections[(size_t) (i + length)]] == isMidSide)
+            ++length;
+
+        chainLengths[(size_t) i] = length;
+        i += length;
+    }
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::setSectionTarget (int slot, const BiquadCoefficients& c, int rampLengthSamples) noexcept
+{
+    if (std::find (activeSections.begin(), activeSections.begin() + numActive, slot) == activeSections.begin() + numActive)
+        return;
+
+    auto numTicks = getNumTicks (rampLengthSamples);
+    auto mask = channelMasks[(size_t) slot];
+    Section target { (SampleType) c.b0, (SampleType) c.b1, (SampleType) c.b2, (SampleType) c.a1, (SampleType) c.a2 };
+    PreciseSection preciseTarget { c.b0, c.b1, c.b2, c.a1, c.a2 };
+
+    // the chains are split by precision
+    if (setPrecision (slot, needsDoublePrecision (c)))
+    {
+        numTicks = 0;
+        updateChains();
+    }
+
+    targets[(size_t) slot] = target;
+    preciseTargets[(size_t) slot] = preciseTarget;
+    rampTicks[(size_t) slot] = numTicks;
+
+    if (numTicks > 0)
+    {
+        steps[(size_t) slot] = makeStep (sections[(size_t) slot], target, (SampleType) 1 / (SampleType) numTicks);
+        preciseSteps[(size_t) slot] = makeStep (preciseSections[(size_t) slot], preciseTarget, 1.0 / numTicks);
+    }
+    else
+    {
+        sections[(size_t) slot] = target;
+        preciseSections[(size_t) slot] = preciseTarget;
+    }
+
+   #if JUCE_USE_SIMD
+    if (vecSections == nullptr)
+        return;
+
+    constexpr auto lanes = Vec::size();
+
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+        if (((activeGroups[(size_t) slot] >> group) & 1) == 0)
+            continue;
+
+        // lanes outside the mask keep their identity section
+        auto index = getVecIndex (slot, group);
+        auto vecTarget = vecTargets[index];
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            auto ch = group * lanes + lane;
+            if (ch >= numChannels || ((mask >> ch) & 1) == 0)
+                continue;
+
+            vecTarget.b0.set (lane, target.b0);
+            vecTarget.b1.set (lane, target.b1);
+            vecTarget.b2.set (lane, target.b2);
+            vecTarget.a1.set (lane, target.a1);
+            vecTarget.a2.set (lane, target.a2);
+        }
+
+        vecTargets[index] = vecTarget;
+
+        if (numTicks > 0)
+            vecSteps[index] = makeStep (vecSections[index], vecTarget, Vec::expand ((SampleType) 1 / (SampleType) numTicks));
+        else
+            vecSections[index] = vecTarget;
+    }
+   #endif
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+{
+    if (context.isBypassed || numActive == 0)
+        return;
+
+    auto block = context.getOutputBlock();
+
+    // the pair has to exist in this block for mid/side to mean anything
+    midSideActive = hasMidSide && midSideLeft >= 0 && midSideRight >= 0
+                     && (size_t) juce::jmax (midSideLeft, midSideRight) < juce::jmin (numChannels, block.getNumChannels());
+
+   #if JUCE_USE_SIMD
+    if (numChannels > 1 && block.getNumChannels() > 1 && maxBlockSize > 0)
+    {
+        // hosts occasionally send more than they announced in prepareToPlay
+        for (size_t start = 0; start < block.getNumSamples(); start += maxBlockSize)
+        {
+            auto subBlock = block.getSubBlock (start, juce::jmin (maxBlockSize, block.getNumSamples() - start));
+            processVectorised (subBlock);
+        }
+        return;
+    }
+   #endif
+
+    processScalar (block);
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::processPrecise (int i, SampleType* const* data, size_t stride, size_t numSamples) noexcept
+{
+    auto length = chainLengths[(size_t) i];
+    auto mask = channelMasks[(size_t) activeSections[(size_t) i]];
+
+    std::array<PreciseSection, maxChainSections> c;
+    std::array<const PreciseSection*, maxChainSections> chainSteps, chainTargets;
+    std::array<int, maxChainSections> ticks;
+    std::array<double*, maxChainSections> chainState;
+
+    auto loadChain = [&]
+    {
+        for (int k = 0; k < length; ++k)
+        {
+            auto slot = (size_t) activeSections[(size_t) (i + k)];
+            c[(size_t) k] = preciseSections[slot];
+            ticks[(size_t) k] = rampTicks[slot];
+            chainSteps[(size_t) k] = &preciseSteps[slot];
+            chainTargets[(size_t) k] = &preciseTargets[slot];
+        }
+    };
+
+    loadChain();
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        if (data[ch] == nullptr || ((mask >> ch) & 1) == 0)
+            continue;
+
+        loadChain();
+
+        for (int k = 0; k < length; ++k)
+            chainState[(size_t) k] = getPreciseState (activeSections[(size_t) (i + k)], ch);
+
+        for (size_t start = 0; start < numSamples; start += preciseBufferSize)
+        {
+            auto num = juce::jmin (preciseBufferSize, numSamples - start);
+            auto* samples = data[ch] + start * stride;
+
+            for (size_t n = 0; n < num; ++n)
+                preciseBuffer[n] = (double) samples[n * stride];
+
+            runChain (length, preciseBuffer.get(), num, c.data(), chainSteps.data(), chainTargets.data(),
+                      ticks.data(), controlInterval, chainState.data());
+
+            for (size_t n = 0; n < num; ++n)
+                samples[n * stride] = (SampleType) preciseBuffer[n];
+        }
+
+        for (int k = 0; k < length; ++k)
+            flushDenormals (chainState[(size_t) k]);
+    }
+
+    for (int k = 0; k < length; ++k)
+    {
+        auto slot = (size_t) activeSections[(size_t) (i + k)];
+        preciseSections[slot] = c[(size_t) k];
+        rampTicks[slot] = ticks[(size_t) k];
+    }
+}
+
+template <typename SampleType>
+void FilterCascade<SampleType>::processScalar (juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    auto numSamples = block.getNumSamples();
+    auto channels = juce::jmin (numChannels, block.getNumChannels());
+
+    std::array<Section, maxChainSections> c;
+    std::array<const Section*, maxChainSections> chainSteps, chainTargets;
+    std::array<int, maxChainSections> ticks;
+    std::array<SampleType*, maxChainSections> chainState;
+    std::array<SampleType*, CascadeSetup::maxChannels> channelData {};
+
+    for (size_t ch = 0; ch < channels; ++ch)
+        channelData[ch] = block.getChannelPointer (ch);
+
+    auto inMidSide = false;
+
+    for (int i = 0; i < numActive; i += chainLengths[(size_t) i])
+    {
+        if (midSideActive && midSide[(size_t) activeSections[(size_t) i]] != inMidSide)
+        {
+            inMidSide = ! inMidSide;
+            convertMidSide (block.getChannelPointer ((size_t) midSideLeft), block.getChannelPointer ((size_t) midSideRight), 1, numSamples, inMidSide);
+        }
+
+        if (precise[(size_t) activeSections[(size_t) i]])
+        {
+            processPrecise (i, channelData.data(), 1, numSamples);
+            continue;
+        }
+
+        auto length = chainLengths[(size_t) i];
+        auto mask = channelMasks[(size_t) activeSections[(size_t) i]];
+
+        auto loadChain = [&]
+        {
+            for (int k = 0; k < length; ++k)
+            {
+                auto slot = (size_t) activeSections[(size_t) (i + k)];
+                c[(size_t) k] = sections[slot];
+                ticks[(size_t) k] = rampTicks[slot];
+                chainSteps[(size_t) k] = &steps[slot];
+                chainTargets[(size_t) k] = &targets[slot];
+            }
+        };
+
+        loadChain();
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            if (((mask >> ch) & 1) == 0)
+                continue;
+
+            // every channel follows the same ramp, so each one starts from the stored values
+            loadChain();
+
+            for (int k = 0; k < length; ++k)
+                chainState[(size_t) k] = getState (activeSections[(size_t) (i + k)], ch);
+
+            runChain (length, block.getChannelPointer (ch), numSamples, c.data(), chainSteps.data(), chainTargets.data(),
+                      ticks.data(), controlInterval, chainState.data());
+
+            for (int k = 0; k < length; ++k)
+                flushDenormals (chainState[(size_t) k]);
+        }
+
+        for (int k = 0; k < length; ++k)
+        {
+            auto slot = (size_t) activeSections[(size_t) (i + k)];
+            sections[slot] = c[(size_t) k];
+            rampTicks[slot] = ticks[(size_t) k];
+        }
+    }
+
+    if (inMidSide)
+        convertMidSide (block.getChannelPointer ((size_t) midSideLeft), block.getChannelPointer ((size_t) midSideRight), 1, numSamples, false);
+}
+
+#if JUCE_USE_SIMD
+template <typename SampleType>
+void FilterCascade<SampleType>::processVectorised (juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    constexpr auto lanes = Vec::size();
+    auto numSamples = block.getNumSamples();
+    auto channels = juce::jmin (numChannels, block.getNumChannels());
+
+    // channel ch sits in lane ch % lanes of group ch / lanes, one sample every lanes values
+    auto getScratch = [this] (size_t ch)
+    {
+        return reinterpret_cast<SampleType*> (interleaved + (ch / lanes) * maxBlockSize) + ch % lanes;
+    };
+
+    auto isMidSideLane = [this] (size_t ch)
+    {
+        return midSideActive && (ch == (size_t) midSideLeft || ch == (size_t) midSideRight);
+    };
+
+    auto inMidSide = midSideActive && midSide[(size_t) activeSections[0]];
+
+    // pack channel (group * lanes + lane) into lane of group's interleaved buffer
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+        auto* dest = reinterpret_cast<SampleType*> (interleaved + group * maxBlockSize);
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            auto ch = group * lanes + lane;
+
+            if (isMidSideLane (ch) && inMidSide)
+            {
+                // encoding on the way in costs nothing over the plain copy
+                auto* l = block.getChannelPointer ((size_t) midSideLeft);
+                auto* r = block.getChannelPointer ((size_t) midSideRight);
+                auto sign = ch == (size_t) midSideLeft ? (SampleType) 1 : (SampleType) -1;
+
+                for (size_t n = 0; n < numSamples; ++n)
+                    dest[n * lanes + lane] = (l[n] + sign * r[n]) * (SampleType) 0.5;
+            }
+            else if (ch < channels)
+            {
+                auto* src = block.getChannelPointer (ch);
+                for (size_t n = 0; n < numSamples; ++n)
+                    dest[n * lanes + lane] = src[n];
+            }
+            else
+            {
+                for (size_t n = 0; n < numSamples; ++n)
+                    dest[n * lanes + lane] = 0;
+            }
+        }
+    }
+
+    std::array<VecSection, maxChainSections> c;
+    std::array<const VecSection*, maxChainSections> chainSteps, chainTargets;
+    std::array<int, maxChainSections> ticks;
+    std::array<Vec*, maxChainSections> chainState;
+    std::array<SampleType*, CascadeSetup::maxChannels> channelData {};
+
+    for (size_t ch = 0; ch < channels; ++ch)
+        channelData[ch] = getScratch (ch);
+
+    for (int i = 0; i < numActive; i += chainLengths[(size_t) i])
+    {
+        // switching in between is done in the (cache warm) scratch buffer
+        if (midSideActive && midSide[(size_t) activeSections[(size_t) i]] != inMidSide)
+        {
+            inMidSide = ! inMidSide;
+            convertMidSide (getScratch ((size_t) midSideLeft), getScratch ((size_t) midSideRight), lanes, numSamples, inMidSide);
+        }
+
+        // double chains go through the scratch buffer a lane at a time
+        if (precise[(size_t) activeSections[(size_t) i]])
+        {
+            processPrecise (i, channelData.data(), lanes, numSamples);
+            continue;
+        }
+
+        auto length = chainLengths[(size_t) i];
+        auto groups = activeGroups[(size_t) activeSections[(size_t) i]];
+
+        for (int k = 0; k < length; ++k)
+            ticks[(size_t) k] = rampTicks[(size_t) activeSections[(size_t) (i + k)]];
+
+        for (size_t group = 0; group < numGroups; ++group)
+        {
+            if (((groups >> group) & 1) == 0)
+                continue;
+
+            for (int k = 0; k < length; ++k)
+            {
+                auto slot = activeSections[(size_t) (i + k)];
+                auto index = getVecIndex (slot, group);
+                c[(size_t) k] = vecSections[index];
+                ticks[(size_t) k] = rampTicks[(size_t) slot];
+                chainSteps[(size_t) k] = vecSteps + index;
+                chainTargets[(size_t) k] = vecTargets + index;
+                chainState[(size_t) k] = getVecState (slot, group);
+            }
+
+            runChain (length, interleaved + group * maxBlockSize, numSamples, c.data(), chainSteps.data(), chainTargets.data(),
+                      ticks.data(), controlInterval, chainState.data());
+
+            for (int k = 0; k < length; ++k)
+                vecSections[getVecIndex (activeSections[(size_t) (i + k)], group)] = c[(size_t) k];
+        }
+
+        for (int k = 0; k < length; ++k)
+            rampTicks[(size_t) activeSections[(size_t) (i + k)]] = ticks[(size_t) k];
+    }
+
+    for (size_t group = 0; group < numGroups; ++group)
+    {
+        auto* src = reinterpret_cast<const SampleType*> (interleaved + group * maxBlockSize);
+
+        for (size_t lane = 0; lane < lanes && group * lanes + lane < channels; ++lane)
+        {
+            auto ch = group * lanes + lane;
+            auto* dest = block.getChannelPointer (ch);
+
+            if (isMidSideLane (ch) && inMidSide)
+            {
+                // and decoded on the way out
+                auto* m = getScratch ((size_t) midSideLeft);
+                auto* s = getScratch ((size_t) midSideRight);
+                auto sign = ch == (size_t) midSideLeft ? (SampleType) 1 : (SampleType) -1;
+
+                for (size_t n = 0; n < numSamples; ++n)
+                    dest[n] = m[n * lanes] + sign * s[n * lanes];
+            }
+            else
+            {
+                for (size_t n = 0; n < numSamples; ++n)
+                    dest[n] = src[n * lanes + lane];
+            }
+        }
+    }
+}
+#endif
+
+//==============================================================================
+template class FilterCascade<float>;
+template class FilterCascade<double>;
@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    FilterCascade.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+
+//==============================================================================
+/**
+    Everything the audio thread needs to run the EQ, as designed by the
+    CoefficientDesigner. Sections are addressed by a fixed slot so a band
+    keeps its filter state when other bands are switched on or off.
+*/
+struct CascadeSetup
+{
+    static constexpr int maxSections = 72;  // eight bands of up to eight sections, then the phase correction
+    static constexpr int maxChannels = 64;
+    static constexpr uint64_t allChannels = ~(uint64_t) 0;
+
+    std::array<BiquadCoefficients, maxSections> sections;
+    std::array<uint64_t, maxSections> channelMasks {};   // bit n set: the section runs on channel n
+    std::array<int, maxSections> activeSections {};
+    int numActive = 0;
+    bool linearPhase = false;
+
+    /** By slot: the section sees mid in channel midSideLeft and side in channel
+        midSideRight instead of left and right. The pair is encoded wherever the flag
+        goes on between two active sections, and decoded wherever it goes off. */
+    std::array<bool, maxSections> midSide {};
+    int midSideLeft = -1, midSideRight = -1;
+
+    /** A band whose gain follows the level in its own frequency range, see DynamicBands. */
+    struct DynamicBand
+    {
+        int slot = 0;
+        FilterDesign::GainPrototype prototype;  // at sampleRate, like the sections
+        BiquadCoefficients detector;            // at the host rate
+        double gainDb = 0.0, thresholdDb = 0.0, ratio = 1.0;
+        double attack = 0.0, release = 0.0;     // envelope follower pole at the host rate
+        bool sidechain = false;
+    };
+
+    std::array<DynamicBand, maxSections> dynamicBands;
+    int numDynamic = 0;
+
+    /** The sections are designed for sampleRate, which is the host rate << oversamplingOrder. */
+    double sampleRate = 0.0;
+    int oversamplingOrder = 0, oversamplingQuality = 0;
+
+    /** How much louder the EQ makes things, see LoudnessMeter::estimateChange(). Only
+        worked out while auto gain is on. */
+    double loudnessChangeDb = 0.0;
+
+    void addSection (int slot, const BiquadCoefficients& c, uint64_t channelMask = allChannels) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (slot, maxSections));
+        sections[(size_t) slot] = c;
+        channelMasks[(size_t) slot] = channelMask;
+        midSide[(size_t) slot] = false;
+        activeSections[(size_t) numActive++] = slot;
+    }
+
+    void clear() noexcept
+    {
+        numActive = 0;
+        numDynamic = 0;
+        loudnessChangeDb = 0.0;
+    }
+
+    bool hasSameSections (const CascadeSetup& other) const noexcept
+    {
+        if (numActive != other.numActive)
+            return false;
+
+        for (int i = 0; i < numActive; ++i)
+        {
+            auto slot = activeSections[(size_t) i];
+            if (slot != other.activeSections[(size_t) i] || sections[(size_t) slot] != other.sections[(size_t) slot])
+                return false;
+        }
+
+        return true;
+    }
+};
+
+//==============================================================================
+/**
+    Series of biquads run band-major: each chain of consecutive active sections
+    that run on the same channels processes the whole block for every channel
+    before the next chain starts, with the chain's state held in locals. Within a
+    chain every sample passes through all of its sections in turn, which is what
+    keeps a steep slope's eight sections from costing eight passes over the block.
+    Disabled sections are never visited.
+
+    When SIMD is available and there is more than one channel, the channels are
+    packed into the lanes of a juce::dsp::SIMDRegister (in float, stereo and quad fit one
+    SSE register, 7.1 two) so a single transposed direct form II loop advances
+    all of them at once. Mono, or builds without SIMD, use the scalar loop.
+
+    Each section can be limited to a subset of the channels. The scalar loop
+    simply skips the others; in the vectorised loop a lane outside the mask gets
+    the identity section (b0 = 1, everything else 0), which passes it through
+    exactly, and groups with no lane in the mask aren't run at all.
+
+    Mid/side sections run in the order they were added, and the pair is encoded
+    and decoded in place wherever they meet left/right sections. An encode at
+    the very start is folded into packing the lanes and a decode at the very
+    end into unpacking them, so a cascade that only switches once costs no
+    extra pass at all; each switch in between is one pass over the pair in the
+    scratch buffer.
+
+    When smoothing is on, a section whose coefficients change glides to the new
+    set by linear interpolation, stepped every controlInterval samples inside
+    the block. The set of stable (a1, a2) pairs is convex, so every step in
+    between two stable designs is stable too, and the only per-step cost is
+    five additions per section - no redesign happens on the audio thread.
+
+    SampleType is float or double; the coefficients and state use the same
+    precision as the audio, so a 64-bit host never converts. The exception is a
+    float section with a pole very close to the unit circle (a low frequency, or a
+    high Q at a high rate), whose recursion amplifies the rounding of a 24 bit state
+    far above the noise floor: see needsDoublePrecision(). Those chains run one
+    channel at a time in double through a small buffer, converting on the way in and out.
+*/
+template <typename SampleType>
+class FilterCascade
+{
+public:
+    FilterCascade() = default;
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    /** Picks up a new set of coefficients; clears the state of sections, or channels of
+        a section, that were switched off. */
+    void setSetup (const CascadeSetup& newSetup) noexcept;
+
+    /** Moves one running section to new coefficients, on the channels it already runs
+        on, gliding over rampLengthSamples. Cheap enough to call for every block when
+        a band is modulated; sections that aren't active are left alone. Like any other
+        glide, a ramp shorter than two control intervals still takes two. */
+    void setSectionTarget (int slot, const BiquadCoefficients& c, int rampLengthSamples) noexcept;
+
+    /** Coefficient changes glide over rampLengthSamples, updated every controlInterval
+        samples. The coefficients step at the start of each interval, so a glide takes at
+        least two of them: halfway for the first, there for the second. A ramp length of 0
+        switches immediately. */
+    void setSmoothing (int rampLengthSamples, int controlInterval) noexcept;
+
+    void process (const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept;
+
+    /** True if a section is run in double precision even though SampleType is float, in
+        which case its coefficients aren't rounded to float either. Always false for double. */
+    static bool needsDoublePrecision (const BiquadCoefficients& c) noexcept;
+
+private:
+    void processScalar (juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** How many control intervals a glide over rampLengthSamples steps through. */
+    int getNumTicks (int rampLengthSamples) const noexcept;
+
+    template <typename Type>
+    struct SectionOf
+    {
+        Type b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    };
+
+    using Section = SectionOf<SampleType>;
+    using PreciseSection = SectionOf<double>;
+
+    /** Splits the active sections into chains, see chainLengths. */
+    void updateChains() noexcept;
+
+    /** Runs the chain starting at activeSections[i] in double on every channel in its mask
+        whose data isn't null, sample n of a channel being at data[ch][n * stride]. */
+    void processPrecise (int i, SampleType* const* data, size_t stride, size_t numSamples) noexcept;
+
+    /** Moves a running slot's state between the SampleType and the double storage when its
+        precision changes, and returns true if it did; the coefficients then jump rather than glide. */
+    bool setPrecision (int slot, bool shouldBePrecise) noexcept;
+
+    /** Longest chain run in one pass; a 96 dB/oct band fits in one. */
+    static constexpr int maxChainSections = 8;
+
+    inline SampleType* getState (int slot, size_t channel) noexcept   { return state.get() + (((size_t) slot * numChannels + channel) * 2); }
+    inline double* getPreciseState (int slot, size_t channel) noexcept  { return preciseState.get() + (((size_t) slot * numChannels + channel) * 2); }
+
+    /** Current coefficients, plus the per-tick increment and final value while ramping. */
+    std::array<Section, CascadeSetup::maxSections> sections, steps, targets;
+    std::array<int, CascadeSetup::maxSections> rampTicks {};
+    std::array<uint64_t, CascadeSetup::maxSections> channelMasks {};
+    std::array<int, CascadeSetup::maxSections> activeSections {};
+    std::array<int, CascadeSetup::maxSections> chainLengths {};    // by index into activeSections, at the start of each chain
+    int numActive = 0;
+    std::array<bool, CascadeSetup::maxSections> midSide {};
+    int midSideLeft = -1, midSideRight = -1;
+    bool hasMidSide = false, midSideActive = false;
+    int rampLength = 0;
+    size_t controlInterval = 32;
+
+    juce::HeapBlock<SampleType> state;
+    size_t numChannels = 0;
+
+    /** The same for the slots that need double precision. */
+    std::array<PreciseSection, CascadeSetup::maxSections> preciseSections, preciseSteps, preciseTargets;
+    std::array<bool, CascadeSetup::maxSections> precise {};
+    juce::HeapBlock<double> preciseState, preciseBuffer;
+    size_t preciseBufferSize = 0;
+
+   #if JUCE_USE_SIMD
+    using Vec = juce::dsp::SIMDRegister<SampleType>;
+
+    struct VecSection
+    {
+        Vec b0, b1, b2, a1, a2;
+    };
+
+    void processVectorised (juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    inline size_t getVecIndex (int slot, size_t group) const noexcept  { return (size_t) slot * numGroups + group; }
+    inline Vec* getVecState (int slot, size_t group) noexcept           { return vecState + ((size_t) slot * numGroups + group) * 2; }
+
+    /** Bit g set: group g of the slot has at least one lane to process. */
+    std::array<uint64_t, CascadeSetup::maxSections> activeGroups {};
+
+    juce::HeapBlock<char> vecMemory;
+    VecSection* vecSections = nullptr;
+    VecSection* vecSteps = nullptr;
+    VecSection* vecTargets = nullptr;
+    Vec* vecState = nullptr;
+    Vec* interleaved = nullptr;
+    size_t numGroups = 0, maxBlockSize = 0;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterCascade)
+};
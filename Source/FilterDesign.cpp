@@ -0,0 +1,362 @@
+/*
+  ==============================================================================
+
+    FilterDesign.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterDesign.h"
+
+namespace FilterDesign
+{
+
+static BiquadCoefficients normalise (double b0, double b1, double b2, double a0, double a1, double a2) noexcept
+{
+    auto a0Inv = 1.0 / a0;
+    return { b0 * a0Inv, b1 * a0Inv, b2 * a0Inv, a1 * a0Inv, a2 * a0Inv };
+}
+
+//==============================================================================
+/** One section of an analogue low pass prototype with its corner at 1 rad/s:
+    a pole pair at frequency with the given q, or with q == 0 the real pole -frequency. */
+struct PrototypeSection
+{
+    double frequency, q;
+};
+
+/** Order n takes (n + 1) / 2 sections, so its entries start at n * n / 4. Odd orders lead
+    with their real pole; the pairs follow in order of rising q. */
+static int getTableOffset (int order) noexcept
+{
+    return order * order / 4;
+}
+
+/** Every Butterworth section is at the corner, so only the q differs. */
+static const double butterworthQs[] =
+{
+    0.0,   // 1
+    0.7071067811865476,   // 2
+    0.0, 1.0,   // 3
+    0.541196100146197, 1.3065629648763766,   // 4
+    0.0, 0.6180339887498948, 1.618033988749895,   // 5
+    0.5176380902050415, 0.7071067811865476, 1.9318516525781368,   // 6
+    0.0, 0.5549581320873712, 0.8019377358048383, 2.246979603717467,   // 7
+    0.5097955791041592, 0.6013448869350453, 0.8999762231364158, 2.5629154477415064,   // 8
+    0.0, 0.5320888862379561, 0.6527036446661393, 1.0, 2.879385241571817,   // 9
+    0.5062325628940014, 0.5611631188171804, 0.7071067811865476, 1.1013446322926335, 3.196226610749831,   // 10
+    0.0, 0.5211085581132028, 0.5943511444371404, 0.7635211184333676, 1.2036156237755653,   // 11
+    3.513337091666135,
+    0.5043144802900764, 0.541196100146197, 0.6302362070051323, 0.8213398158522908, 1.3065629648763766,   // 12
+    3.830648787770195,
+    0.0, 0.5149639154748638, 0.5646807808791463, 0.6679930798878865, 0.8801813576307554,   // 13
+    1.4100200484265293, 4.148114905279377,
+    0.503163788290089, 0.5297264862561453, 0.590511054787033, 0.7071067811865476, 0.9397929599938074,   // 14
+    1.513871321542845, 4.465702135190253,
+    0.0, 0.5111702974325146, 0.5473181392530234, 0.6180339887498948, 0.7472382749323043,   // 15
+    1.0, 1.618033988749895, 4.783386116752814,
+    0.5024192861881558, 0.5224986149396889, 0.5669440348163578, 0.6468217833599901, 0.7881546234512502,   // 16
+    1.0606776859903475, 1.7224470982383342, 5.101148618689164,
+};
+
+/** Bessel poles scaled from unit group delay to -3 dB at the corner. */
+static const PrototypeSection besselSections[] =
+{
+    { 1.0, 0.0 },   // 1
+    { 1.2720196495140688, 0.5773502691896258 },   // 2
+    { 1.3226757999104448, 0.0 }, { 1.4476171331469871, 0.6910466258250713 },   // 3
+    { 1.4301715599939904, 0.5219345816689802 }, { 1.6033575162169735, 0.8055382818416658 },   // 4
+    { 1.502316271447479, 0.0 }, { 1.556347122296926, 0.5635356208514564 }, { 1.7553777766370957, 0.916477373948248 },   // 5
+    { 1.6039191287737897, 0.5103178247487706 }, { 1.6891682676204662, 0.6111945468780011 }, { 1.9047076123027609, 1.0233139538267226 },   // 6
+    { 1.6843681792731326, 0.0 }, { 1.7163560448708697, 0.5323556978995455 }, { 1.8224174788579812, 0.6608213892970827 },   // 7
+    { 2.0494909002691033, 1.1262575419830387 },
+    { 1.7784659117745898, 0.5059910693974747 }, { 1.8320926011985597, 0.5596091647958011 }, { 1.9531957590220252, 0.7108520744416978 },   // 8
+    { 2.1887262305274406, 1.2256694254081735 },
+    { 1.8566005012279714, 0.0 }, { 1.8784042242804797, 0.5197086240451076 }, { 1.9478651342257987, 0.5894060996874924 },   // 9
+    { 2.080405435862858, 0.7606110044103144 }, { 2.322332358362595, 1.3219115847364595 },
+    { 1.9427041916588805, 0.5039127272757195 }, { 1.9805531088151205, 0.53755215132519 }, { 2.06220731792685, 0.6204701555564507 },   // 10
+    { 2.203752625930455, 0.8097909648413327 }, { 2.450626843054623, 1.4153088691634532 },
+    { 2.016701473450915, 0.0 }, { 2.032797871535693, 0.513291150483326 }, { 2.0830699402530692, 0.557757625272046 },   // 11
+    { 2.174453280505294, 0.6521297902675381 }, { 2.323271650022259, 0.858254347396066 }, { 2.5740366210614316, 1.5061431962697265 },
+    { 2.096133225436222, 0.502755558194734 }, { 2.1247253847254344, 0.5259362020385182 }, { 2.1849672263910604, 0.5793672386225313 },   // 12
+    { 2.284318253986556, 0.6840080681448927 }, { 2.439126114315687, 0.9059471070235706 }, { 2.6929892508380564, 1.5946569350718554 },
+    { 2.166082705638087, 0.0 }, { 2.178598196617469, 0.5095782599338472 }, { 2.2172453623823816, 0.5406383596634043 },   // 13
+    { 2.285702547378191, 0.6018218159543035 }, { 2.391709506929917, 0.7158841172254207 }, { 2.551525858182257, 0.9528580756207767 },
+    { 2.8078786505790707, 1.6810584273549123 },
+    { 2.2400571613228784, 0.5020454285849758 }, { 2.2626574653190277, 0.519027293278674 }, { 2.3096146223047676, 0.5566807727401434 },   // 14
+    { 2.3849797692787695, 0.6247770824581881 }, { 2.496634345721827, 0.7476250682567941 }, { 2.6606908894773387, 0.9989984429929084 },
+    { 2.9190571447086464, 1.7655274349311547 },
+    { 2.306370057031028, 0.0 }, { 2.3164635686610575, 0.5072340855764126 }, { 2.347410647247316, 0.5302420369124705 },   // 15
+    { 2.401378095832278, 0.5736141829178981 }, { 2.4826450933759303, 0.6480124714101858 }, { 2.5991524699272803, 0.779150095945073 },
+    { 2.7668354098996075, 1.0443909111393213 }, { 3.02683647605053, 1.8482198878508724 },
+    { 2.3758230809667467, 0.5015784002304348 }, { 2.394277099115457, 0.5145709538349861 }, { 2.4322770804325837, 0.5426783660911229 },   // 16
+    { 2.4922550477579106, 0.5911446595455925 }, { 2.578629457922961, 0.6713823796136132 }, { 2.6993501802423485, 0.8104103028798556 },
+    { 2.870160994175357, 1.0890637691752512 }, { 3.131491674042932, 1.9292718407010334 },
+};
+
+static_assert (sizeof (butterworthQs) / sizeof (butterworthQs[0]) == (maxSlopeOrder + 1) * (maxSlopeOrder + 1) / 4,
+               "one entry per section of every order");
+static_assert (sizeof (besselSections) / sizeof (besselSections[0]) == (maxSlopeOrder + 1) * (maxSlopeOrder + 1) / 4,
+               "one entry per section of every order");
+
+//==============================================================================
+
+BiquadCoefficients design (int type, double sampleRate, double frequency, double q, double gainDb)
+{
+    jassert (sampleRate > 0.0);
+    jassert (q > 0.0);
+
+    frequency = juce::jlimit (1.0, sampleRate * 0.499, frequency);
+
+    if (hasGain (type))
+        return designWithGain (makeGainPrototype (type, sampleRate, frequency, q), gainDb);
+
+    return designFromPrewarp (type, std::tan (juce::MathConstants<double>::pi * frequency / sampleRate), q);
+}
+
+BiquadCoefficients designFromPrewarp (int type, double tanHalfOmega, double q) noexcept
+{
+    switch (type)
+    {
+        case lowPass:
+        {
+            auto n = 1.0 / tanHalfOmega;
+            auto nSquared = n * n;
+            auto invQ = 1.0 / q;
+            auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+            return { c1, c1 * 2.0, c1, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared) };
+        }
+        case highPass:
+        {
+            auto n = tanHalfOmega;
+            auto nSquared = n * n;
+            auto invQ = 1.0 / q;
+            auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+            return { c1, c1 * -2.0, c1, c1 * 2.0 * (nSquared - 1.0), c1 * (1.0 - invQ * n + nSquared) };
+        }
+        case bandPass:
+        {
+            auto n = 1.0 / tanHalfOmega;
+            auto nSquared = n * n;
+            auto invQ = 1.0 / q;
+            auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+            return { c1 * n * invQ, 0.0, -c1 * n * invQ, c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - invQ * n + nSquared) };
+        }
+        case notch:
+        {
+            auto n = 1.0 / tanHalfOmega;
+            auto nSquared = n * n;
+            auto invQ = 1.0 / q;
+            auto c1 = 1.0 / (1.0 + n * invQ + nSquared);
+
+            return { c1 * (1.0 + nSquared), 2.0 * c1 * (1.0 - nSquared), c1 * (1.0 + nSquared),
+                     c1 * 2.0 * (1.0 - nSquared), c1 * (1.0 - n * invQ + nSquared) };
+        }
+        case allPass:
+        {
+            auto n = 1.0 / tanHalfOmega;
+            auto nSquared = n * n;
+            auto invQ = 1.0 / q;
+            auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+            auto b0 = c1 * (1.0 - n * invQ + nSquared);
+            auto b1 = c1 * 2.0 * (1.0 - nSquared);
+
+            return { b0, b1, 1.0, b1, b0 };
+        }
+        default:
+            jassertfalse;
+            break;
+    }
+
+    return {};
+}
+
+bool hasSlope (int type) noexcept
+{
+    return type == lowPass || type == highPass;
+}
+
+int getSlopeSections (int type, int characteristic, int order, double sampleRate, double frequency, double q,
+                      double* frequencies, double* qs) noexcept
+{
+    jassert (hasSlope (type));
+    jassert (sampleRate > 0.0);
+    jassert (q > 0.0);
+
+    order = juce::jlimit (1, maxSlopeOrder, order);
+    frequency = juce::jlimit (1.0, sampleRate * 0.499, frequency);
+
+    // a Linkwitz-Riley is a Butterworth of half the order, twice over
+    auto twice = characteristic == linkwitzRiley && order % 2 == 0;
+    auto prototypeOrder = twice ? order / 2 : order;
+    auto numPrototype = (prototypeOrder + 1) / 2;
+    auto numSections = twice ? numPrototype * 2 : numPrototype;
+    auto offset = getTableOffset (prototypeOrder);
+
+    for (int i = 0; i < numSections; ++i)
+    {
+        auto index = offset + i % numPrototype;
+        auto section = characteristic == bessel ? besselSections[index] : PrototypeSection { 1.0, butterworthQs[index] };
+
+        // the last section is the sharpest, and carries the resonance
+        if (i == numSections - 1 && section.q > 0.0)
+            section.q *= q * juce::MathConstants<double>::sqrt2;
+
+        // the high pass prototype is the low pass one with s -> 1 / s, which mirrors its poles around the corner
+        auto sectionFrequency = type == lowPass ? frequency * section.frequency : frequency / section.frequency;
+
+        frequencies[i] = juce::jlimit (1.0, sampleRate * 0.499, sectionFrequency);
+        qs[i] = section.q;
+    }
+
+    return numSections;
+}
+
+int designSlope (int type, int characteristic, int order, double sampleRate, double frequency, double q, BiquadCoefficients* dest)
+{
+    double frequencies[maxSlopeSections], qs[maxSlopeSections];
+    auto numSections = getSlopeSections (type, characteristic, order, sampleRate, frequency, q, frequencies, qs);
+
+    for (int i = 0; i < numSections; ++i)
+        dest[i] = designSlopeSection (type, std::tan (juce::MathConstants<double>::pi * frequencies[i] / sampleRate), qs[i]);
+
+    return numSections;
+}
+
+BiquadCoefficients designSlopeSection (int type, double tanHalfOmega, double q) noexcept
+{
+    return q > 0.0 ? designFromPrewarp (type, tanHalfOmega, q)
+                   : designFirstOrder (type, tanHalfOmega);
+}
+
+BiquadCoefficients designFirstOrder (int type, double tanHalfOmega) noexcept
+{
+    jassert (hasSlope (type));
+
+    auto n = 1.0 / tanHalfOmega;
+    auto c1 = 1.0 / (1.0 + n);
+    auto a1 = c1 * (1.0 - n);
+
+    if (type == lowPass)
+        return { c1, c1, 0.0, a1, 0.0 };
+
+    return { c1 * n, -c1 * n, 0.0, a1, 0.0 };
+}
+
+bool hasGain (int type) noexcept
+{
+    return type == peak || type == lowShelf || type == highShelf;
+}
+
+GainPrototype makeGainPrototype (int type, double sampleRate, double frequency, double q)
+{
+    jassert (hasGain (type));
+
+    frequency = juce::jlimit (1.0, sampleRate * 0.499, frequency);
+    auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+    return { type, std::cos (omega), std::sin (omega) / q };
+}
+
+BiquadCoefficients designWithGain (const GainPrototype& prototype, double gainDb) noexcept
+{
+    auto A = std::sqrt (juce::Decibels::decibelsToGain (gainDb, -300.0));
+    return designWithAmplitude (prototype, A, std::sqrt (A));
+}
+
+BiquadCoefficients designWithAmplitude (const GainPrototype& prototype, double A, double sqrtA) noexcept
+{
+    auto coso = prototype.cosOmega;
+
+    if (prototype.type == peak)
+    {
+        auto alpha = prototype.sinOverQ * 0.5;
+        auto c2 = -2.0 * coso;
+        auto alphaTimesA = alpha * A;
+        auto alphaOverA = alpha / A;
+
+        return normalise (1.0 + alphaTimesA, c2, 1.0 - alphaTimesA, 1.0 + alphaOverA, c2, 1.0 - alphaOverA);
+    }
+
+    auto aminus1 = A - 1.0;
+    auto aplus1 = A + 1.0;
+    auto beta = prototype.sinOverQ * sqrtA;
+    auto aminus1TimesCoso = aminus1 * coso;
+
+    if (prototype.type == lowShelf)
+        return normalise (A * (aplus1 - aminus1TimesCoso + beta),
+                          A * 2.0 * (aminus1 - aplus1 * coso),
+                          A * (aplus1 - aminus1TimesCoso - beta),
+                          aplus1 + aminus1TimesCoso + beta,
+                          -2.0 * (aminus1 + aplus1 * coso),
+                          aplus1 + aminus1TimesCoso - beta);
+
+    return normalise (A * (aplus1 + aminus1TimesCoso + beta),
+                      A * -2.0 * (aminus1 + aplus1 * coso),
+                      A * (aplus1 + aminus1TimesCoso - beta),
+                      aplus1 - aminus1TimesCoso + beta,
+                      2.0 * (aminus1 - aplus1 * coso),
+                      aplus1 - aminus1TimesCoso - beta);
+}
+
+double getDecaySamples (const BiquadCoefficients& c, double attenuationDb, double maxSamples) noexcept
+{
+    // poles of z^2 + a1 z + a2: a conjugate pair of radius sqrt (a2), or two real ones
+    auto discriminant = c.a1 * c.a1 - 4.0 * c.a2;
+    auto radius = discriminant < 0.0 ? std::sqrt (c.a2)
+                                     : 0.5 * (std::abs (c.a1) + std::sqrt (discriminant));
+
+    if (radius <= 0.0)
+        return 2.0; // FIR: done after the last tap
+
+    if (radius >= 1.0)
+        return maxSamples;
+
+    return juce::jmin (maxSamples, attenuationDb / (-20.0 * std::log10 (radius)));
+}
+
+std::complex<double> getResponse (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept
+{
+    auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    auto z1 = std::polar (1.0, -omega);
+    auto z2 = z1 * z1;
+
+    auto numerator = c.b0 + c.b1 * z1 + c.b2 * z2;
+    auto denominator = 1.0 + c.a1 * z1 + c.a2 * z2;
+
+    return numerator / denominator;
+}
+
+double getMagnitude (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept
+{
+    return std::abs (getResponse (c, frequency, sampleRate));
+}
+
+double getPhase (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept
+{
+    return std::arg (getResponse (c, frequency, sampleRate));
+}
+
+double getGroupDelay (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept
+{
+    auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    auto z1 = std::polar (1.0, -omega);
+    auto z2 = z1 * z1;
+
+    auto polynomialDelay = [&] (double p0, double p1, double p2)
+    {
+        auto p = p0 + p1 * z1 + p2 * z2;
+        auto weighted = p1 * z1 + 2.0 * p2 * z2;
+        auto norm = std::norm (p);
+
+        // a zero right on the unit circle has no defined delay
+        return norm > 1.0e-20 ? (weighted * std::conj (p)).real() / norm : 0.0;
+    };
+
+    return polynomialDelay (c.b0, c.b1, c.b2) - polynomialDelay (1.0, c.a1, c.a2);
+}
+
+}
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    FilterDesign.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Normalised second order section (a0 == 1). */
+struct BiquadCoefficients
+{
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+
+    bool operator== (const BiquadCoefficients& other) const noexcept
+    {
+        return b0 == other.b0 && b1 == other.b1 && b2 == other.b2 && a1 == other.a1 && a2 == other.a2;
+    }
+    bool operator!= (const BiquadCoefficients& other) const noexcept { return ! operator== (other); }
+};
+
+//==============================================================================
+/**
+    Plain-math biquad designs matching juce::dsp::IIR::Coefficients::make*, but
+    writing into a value type so nothing is allocated and the result can be
+    handed to the audio thread by copy.
+*/
+namespace FilterDesign
+{
+    /** Same order as PhaseEQAudioProcessor::filtersList. */
+    enum FilterType
+    {
+        peak = 0,
+        lowPass,
+        highPass,
+        bandPass,
+        notch,
+        allPass,
+        lowShelf,
+        highShelf,
+        numFilterTypes
+    };
+
+    BiquadCoefficients design (int type, double sampleRate, double frequency, double q, double gainDb);
+
+    /** Alignments of the Low Pass and High Pass slopes, in the order of the CHARACTERISTIC parameter. */
+    enum Characteristic
+    {
+        butterworth = 0,
+        linkwitzRiley,
+        bessel,
+        numCharacteristics
+    };
+
+    /** 6 dB/oct per order, up to 96 dB/oct in eight sections. */
+    constexpr int maxSlopeOrder = 16;
+    constexpr int maxSlopeSections = (maxSlopeOrder + 1) / 2;
+
+    /** True for the types whose slope can be set: Low Pass and High Pass. */
+    bool hasSlope (int type) noexcept;
+
+    /** A Low Pass or High Pass of the given order as cascaded sections, written to dest;
+        returns how many there are, up to maxSlopeSections.
+
+        Each section is the bilinear transform of a pole pair, or the real pole, of
+        the analogue prototype, which comes from tables for every order rather than
+        from root finding. Butterworth and Bessel are -3 dB at the frequency and
+        Linkwitz-Riley -6 dB. Linkwitz-Riley only exists for even orders, so odd
+        ones fall back to Butterworth.
+
+        q scales the sharpest section, taking 1/sqrt 2 as the exact alignment, so
+        order 2 Butterworth is the same section design() makes. */
+    int designSlope (int type, int characteristic, int order, double sampleRate, double frequency, double q, BiquadCoefficients* dest);
+
+    /** The analogue half of designSlope(): each section's corner frequency, already
+        limited to what the designs accept, and its q, which is 0 for the real pole.
+        Returns how many sections there are. */
+    int getSlopeSections (int type, int characteristic, int order, double sampleRate, double frequency, double q,
+                          double* frequencies, double* qs) noexcept;
+
+    /** The other half, for one of those sections once its prewarp is known. */
+    BiquadCoefficients designSlopeSection (int type, double tanHalfOmega, double q) noexcept;
+
+    /** True for the types whose response depends on the gain: peak and the shelves. */
+    bool hasGain (int type) noexcept;
+
+    /** The part of a peak or shelf design that doesn't depend on the gain. */
+    struct GainPrototype
+    {
+        int type = peak;
+        double cosOmega = 1.0, sinOverQ = 0.0;
+    };
+
+    GainPrototype makeGainPrototype (int type, double sampleRate, double frequency, double q);
+
+    /** Finishes a prototype for the given gain with one pow and a sqrt or two, so it
+        is cheap enough to run on the audio thread at a control rate. */
+    BiquadCoefficients designWithGain (const GainPrototype& prototype, double gainDb) noexcept;
+
+    /** The last steps of design(), once the transcendental terms are known, however
+        they were computed (see FastFilterDesign). A is the square root of the linear
+        gain; tanHalfOmega is tan (pi * frequency / sampleRate). */
+    BiquadCoefficients designWithAmplitude (const GainPrototype& prototype, double A, double sqrtA) noexcept;
+    BiquadCoefficients designFromPrewarp (int type, double tanHalfOmega, double q) noexcept;
+
+    /** First order Low Pass or High Pass, as a section with b2 = a2 = 0. */
+    BiquadCoefficients designFirstOrder (int type, double tanHalfOmega) noexcept;
+
+    /** Samples the impulse response takes to decay by attenuationDb, from the
+        section's slowest pole. Capped at maxSamples for poles on or near the unit circle. */
+    double getDecaySamples (const BiquadCoefficients& c, double attenuationDb, double maxSamples) noexcept;
+
+    std::complex<double> getResponse (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept;
+    double getMagnitude (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept;
+    double getPhase (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept;
+
+    /** Group delay in samples at sampleRate, worked out from the coefficients rather than
+        by differentiating the phase: Re (sum k p[k] z^-k / p (z)) for numerator and denominator. */
+    double getGroupDelay (const BiquadCoefficients& c, double frequency, double sampleRate) noexcept;
+}
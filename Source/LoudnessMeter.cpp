@@ -0,0 +1,288 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+
+//==============================================================================
+float LoudnessMeter::getChannelWeight (juce::AudioChannelSet::ChannelType type) noexcept
+{
+    using Set = juce::AudioChannelSet;
+
+    switch (type)
+    {
+        case Set::LFE:
+        case Set::LFE2:
+            return 0.f;
+
+        case Set::leftSurround:
+        case Set::rightSurround:
+        case Set::leftSurroundSide:
+        case Set::rightSurroundSide:
+        case Set::leftSurroundRear:
+        case Set::rightSurroundRear:
+            return 1.41f;
+
+        default:
+            return 1.f;
+    }
+}
+
+LoudnessMeter::KWeighting LoudnessMeter::makeKWeighting (double sampleRate) noexcept
+{
+    // the two stages of BS.1770 from their analogue parameters, so any rate gets the same curve
+    KWeighting k;
+
+    {
+        const double frequency = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+        auto K = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        auto Vh = std::pow (10.0, gainDb / 20.0);
+        auto Vb = std::pow (Vh, 0.4996667741545416);
+        auto a0 = 1.0 + K / q + K * K;
+
+        k.shelf.b0 = (Vh + Vb * K / q + K * K) / a0;
+        k.shelf.b1 = 2.0 * (K * K - Vh) / a0;
+        k.shelf.b2 = (Vh - Vb * K / q + K * K) / a0;
+        k.shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+        k.shelf.a2 = (1.0 - K / q + K * K) / a0;
+    }
+
+    {
+        const double frequency = 38.13547087602444, q = 0.5003270373238773;
+        auto K = std::tan (juce::MathConstants<double>::pi * frequency / sampleRate);
+        auto a0 = 1.0 + K / q + K * K;
+
+        k.highPass.b0 = 1.0;
+        k.highPass.b1 = -2.0;
+        k.highPass.b2 = 1.0;
+        k.highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+        k.highPass.a2 = (1.0 - K / q + K * K) / a0;
+    }
+
+    return k;
+}
+
+double LoudnessMeter::estimateChange (const CascadeSetup& setup, const float* channelWeights, int numChannels, double hostRate)
+{
+    numChannels = juce::jmin (numChannels, CascadeSetup::maxChannels);
+
+    if (setup.numActive == 0 || setup.sampleRate <= 0.0 || hostRate <= 0.0 || numChannels <= 0)
+        return 0.0;
+
+    auto k = makeKWeighting (hostRate);
+    auto hasPair = setup.midSideLeft >= 0 && setup.midSideRight >= 0
+                    && setup.midSideLeft < numChannels && setup.midSideRight < numChannels;
+    double before = 0.0, after = 0.0;
+
+    // third octaves from 25 Hz to 20 kHz, which pink noise fills with equal power
+    for (int band = -16; band <= 13; ++band)
+    {
+        auto frequency = 1000.0 * std::pow (2.0, band / 3.0);
+        if (frequency >= hostRate * 0.45)
+            break;
+
+        auto weighting = FilterDesign::getMagnitude (k.shelf, frequency, hostRate) * FilterDesign::getMagnitude (k.highPass, frequency, hostRate);
+        weighting *= weighting;
+
+        std::array<double, CascadeSetup::maxChannels> power;
+        std::fill (power.begin(), power.begin() + numChannels, 1.0);
+        double midPower = 1.0, sidePower = 1.0;
+
+        for (int i = 0; i < setup.numActive; ++i)
+        {
+            auto slot = (size_t) setup.activeSections[(size_t) i];
+            auto mask = setup.channelMasks[slot];
+            auto magnitude = FilterDesign::getMagnitude (setup.sections[slot], frequency, setup.sampleRate);
+            auto sectionPower = magnitude * magnitude;
+            auto inMidSide = hasPair && setup.midSide[slot];
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                if ((mask & ((uint64_t) 1 << ch)) == 0)
+                    continue;
+
+                if (inMidSide && ch == setup.midSideLeft)        midPower *= sectionPower;
+                else if (inMidSide && ch == setup.midSideRight)  sidePower *= sectionPower;
+                else                                             power[(size_t) ch] *= sectionPower;
+            }
+        }
+
+        if (hasPair)
+        {
+            power[(size_t) setup.midSideLeft] *= (midPower + sidePower) * 0.5;
+            power[(size_t) setup.midSideRight] *= (midPower + sidePower) * 0.5;
+        }
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            before += channelWeights[ch] * weighting;
+            after += channelWeights[ch] * weighting * power[(size_t) ch];
+        }
+    }
+
+    if (before <= 0.0 || after <= 0.0)
+        return 0.0;
+
+    return 10.0 * std::log10 (after / before);
+}
+
+//==============================================================================
+void LoudnessMeter::prepare (double sampleRate, const juce::AudioChannelSet& layout, double windowSeconds)
+{
+    filter = makeKWeighting (sampleRate);
+    samplesPerStep = juce::roundToInt (sampleRate * stepSeconds);
+    stepPosition = 0;
+    stepPower = 0.0;
+
+    weights.resize ((size_t) layout.size());
+    for (int ch = 0; ch < layout.size(); ++ch)
+        weights[(size_t) ch] = getChannelWeight (layout.getTypeOfChannel (ch));
+
+    state.assign ((size_t) layout.size(), {});
+    steps.assign ((size_t) juce::jmax (stepsPerBlock, juce::roundToInt (windowSeconds / stepSeconds)), 0.0);
+
+    fifo.reset();
+    reset();
+}
+
+template <typename SampleType>
+void LoudnessMeter::process (const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    auto numChannels = juce::jmin ((int) block.getNumChannels(), (int) state.size());
+    auto numSamples = (int) block.getNumSamples();
+
+    if (samplesPerStep <= 0)
+        return;
+
+    for (int start = 0; start < numSamples;)
+    {
+        auto length = juce::jmin (numSamples - start, samplesPerStep - stepPosition);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (weights[(size_t) ch] == 0.f)
+                continue;
+
+            auto& s = filter.shelf;
+            auto& h = filter.highPass;
+            auto& z = state[(size_t) ch];
+            auto s1 = z[0], s2 = z[1], h1 = z[2], h2 = z[3];
+            auto* x = block.getChannelPointer ((size_t) ch) + start;
+            double sum = 0.0;
+
+            for (int i = 0; i < length; ++i)
+            {
+                auto in = (double) x[i];
+                auto shelved = s.b0 * in + s1;
+                s1 = s.b1 * in - s.a1 * shelved + s2;
+                s2 = s.b2 * in - s.a2 * shelved;
+
+                // the high pass's numerator is 1, -2, 1 at every rate
+                auto out = shelved + h1;
+                h1 = -2.0 * shelved - h.a1 * out + h2;
+                h2 = shelved - h.a2 * out;
+
+                sum += out * out;
+            }
+
+            z = { s1, s2, h1, h2 };
+            stepPower += sum * weights[(size_t) ch];
+        }
+
+        start += length;
+        stepPosition += length;
+
+        if (stepPosition < samplesPerStep)
+            continue;
+
+        // the reader has fallen behind: the step is lost, which only thins out the window
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 > 0)
+        {
+            fifoBuffer[(size_t) start1] = stepPower / samplesPerStep;
+            fifo.finishedWrite (1);
+        }
+
+        stepPower = 0.0;
+        stepPosition = 0;
+    }
+}
+
+template void LoudnessMeter::process (const juce::dsp::AudioBlock<float>&) noexcept;
+template void LoudnessMeter::process (const juce::dsp::AudioBlock<double>&) noexcept;
+
+//==============================================================================
+void LoudnessMeter::reset() noexcept
+{
+    numSteps = nextStep = 0;
+    loudness = silence;
+    gatedSeconds = 0.0;
+}
+
+bool LoudnessMeter::update() noexcept
+{
+    auto numReady = fifo.getNumReady();
+    if (numReady == 0 || steps.empty())
+        return false;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numReady, start1, size1, start2, size2);
+
+    auto append = [this] (int start, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            steps[(size_t) nextStep] = fifoBuffer[(size_t) (start + i)];
+            nextStep = (nextStep + 1) % (int) steps.size();
+            numSteps = juce::jmin (numSteps + 1, (int) steps.size());
+        }
+    };
+
+    append (start1, size1);
+    append (start2, size2);
+    fifo.finishedRead (size1 + size2);
+
+    // every four consecutive steps make a block; the gates compare mean squares, so only the result needs a log
+    auto capacity = (int) steps.size();
+    auto oldest = (nextStep - numSteps + capacity) % capacity;
+    auto toPower = [] (double lufs) { return std::pow (10.0, (lufs + 0.691) / 10.0); };
+
+    auto gate = [&] (double threshold, double& sum)
+    {
+        auto numPassed = 0;
+        auto block = 0.0;
+        sum = 0.0;
+
+        for (int i = 0; i < numSteps; ++i)
+        {
+            block += steps[(size_t) ((oldest + i) % capacity)];
+
+            if (i >= stepsPerBlock)
+                block -= steps[(size_t) ((oldest + i - stepsPerBlock) % capacity)];
+
+            if (i >= stepsPerBlock - 1 && block / stepsPerBlock > threshold)
+            {
+                sum += block / stepsPerBlock;
+                ++numPassed;
+            }
+        }
+
+        return numPassed;
+    };
+
+    double sum;
+    auto numPassed = gate (toPower (absoluteGate), sum);
+
+    if (numPassed > 0)
+        numPassed = gate (sum / numPassed * std::pow (10.0, relativeGate / 10.0), sum);
+
+    loudness = numPassed > 0 ? -0.691 + 10.0 * std::log10 (sum / numPassed) : silence;
+    gatedSeconds = numPassed * stepSeconds;
+    return true;
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCascade.h"
+
+//==============================================================================
+/**
+    ITU-R BS.1770 loudness over a sliding window, for auto gain.
+
+    The audio thread K-weights each channel with two biquads, run over the block
+    a channel at a time, and sums the weighted mean squares into 100 ms steps.
+    Each finished step is one number pushed into a preallocated
+    juce::AbstractFifo, so process() never allocates or waits.
+
+    Another thread calls update(), which moves the steps into the window, builds
+    the overlapping 400 ms gating blocks from every four of them and applies the
+    absolute and relative gates. getLoudness() is then the integrated loudness
+    of the window in LUFS.
+*/
+class LoudnessMeter
+{
+public:
+    LoudnessMeter() = default;
+
+    static constexpr double stepSeconds = 0.1;
+    static constexpr int stepsPerBlock = 4;                 // 400 ms gating blocks, 75 % overlap
+    static constexpr double absoluteGate = -70.0;           // LUFS
+    static constexpr double relativeGate = -10.0;           // LU below the ungated loudness
+    static constexpr double silence = -100.0;               // what getLoudness() reads with nothing above the gates
+
+    /** Weight of a channel in the sum: 1.41 for the surrounds, none for the LFE. */
+    static float getChannelWeight (juce::AudioChannelSet::ChannelType type) noexcept;
+
+    /** How much louder the setup makes pink noise once K-weighted, from its magnitude
+        response at third octaves. Channels are weighted as in the sum; mid and side
+        sections each count for half of the power of both sides of the pair. */
+    static double estimateChange (const CascadeSetup& setup, const float* channelWeights, int numChannels, double hostRate);
+
+    /** Call it while neither the audio thread nor the reader runs. */
+    void prepare (double sampleRate, const juce::AudioChannelSet& layout, double windowSeconds);
+
+    /** Audio thread. */
+    template <typename SampleType>
+    void process (const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** Reader thread: the window starts over. */
+    void reset() noexcept;
+
+    /** Reader thread: takes in the finished steps and returns true if there were any. */
+    bool update() noexcept;
+
+    double getLoudness() const noexcept                     { return loudness; }
+
+    /** Seconds of the window that passed both gates. */
+    double getGatedSeconds() const noexcept                 { return gatedSeconds; }
+
+private:
+    static constexpr int fifoSize = 256;
+
+    struct KWeighting
+    {
+        BiquadCoefficients shelf, highPass;
+    };
+
+    static KWeighting makeKWeighting (double sampleRate) noexcept;
+
+    KWeighting filter;
+    std::vector<float> weights;
+    std::vector<std::array<double, 4>> state;               // per channel: both sections' transposed direct form II state
+    int samplesPerStep = 0, stepPosition = 0;
+    double stepPower = 0.0;
+
+    juce::AbstractFifo fifo { fifoSize };
+    std::array<double, fifoSize> fifoBuffer {};
+
+    std::vector<double> steps;                              // ring of the window's mean squares, one per step
+    int numSteps = 0, nextStep = 0;
+    double loudness = silence, gatedSeconds = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessMeter)
+};
@@ -0,0 +1,462 @@
+/*
+  ==============================================================================
+
+    MatchEQ.cpp
+
+  ==============================================================================
+*/
+
+#include "MatchEQ.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int hopSize = MatchEQ::fftSize / 2;
+
+    /** One thread's share of the frames of a file, with a reader, FFT and running sum of its own. */
+    class ChunkWorker  : public juce::Thread
+    {
+    public:
+        ChunkWorker (juce::AudioFormatReader* r, juce::int64 first, juce::int64 last, const std::function<bool()>& exit)
+            : juce::Thread ("PhaseEQ Match"), reader (r), firstFrame (first), endFrame (last), shouldExit (exit),
+              power ((size_t) MatchEQ::fftSize / 2 + 1, 0.0)
+        {
+        }
+
+        void run() override
+        {
+            juce::dsp::FFT fft (MatchEQ::fftOrder);
+            juce::dsp::WindowingFunction<float> window ((size_t) MatchEQ::fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+            juce::AudioBuffer<float> buffer ((int) reader->numChannels, hopSize);
+            std::vector<float> history ((size_t) MatchEQ::fftSize), fftData ((size_t) MatchEQ::fftSize * 2);
+
+            // mono, so the match is of the overall tone rather than of one side
+            auto mix = [&] (float* dest, juce::int64 position)
+            {
+                reader->read (&buffer, 0, hopSize, position, true, true);
+                auto gain = 1.f / (float) buffer.getNumChannels();
+
+                juce::FloatVectorOperations::copyWithMultiply (dest, buffer.getReadPointer (0), gain, hopSize);
+                for (int ch = 1; ch < buffer.getNumChannels(); ++ch)
+                    juce::FloatVectorOperations::addWithMultiply (dest, buffer.getReadPointer (ch), gain, hopSize);
+            };
+
+            mix (history.data(), firstFrame * hopSize);
+
+            for (auto frame = firstFrame; frame < endFrame; ++frame)
+            {
+                if (threadShouldExit() || (shouldExit != nullptr && shouldExit()))
+                    return;
+
+                // frames overlap by half, so each one only reads its second half
+                mix (history.data() + hopSize, (frame + 1) * hopSize);
+
+                std::copy (history.begin(), history.end(), fftData.begin());
+                window.multiplyWithWindowingTable (fftData.data(), (size_t) MatchEQ::fftSize);
+                fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+                for (size_t k = 0; k < power.size(); ++k)
+                    power[k] += (double) fftData[k] * fftData[k];
+
+                std::copy (history.begin() + hopSize, history.end(), history.begin());
+            }
+
+            finished = true;
+        }
+
+        std::unique_ptr<juce::AudioFormatReader> reader;
+        juce::int64 firstFrame, endFrame;
+        const std::function<bool()>& shouldExit;
+        std::vector<double> power;
+        bool finished = false;
+    };
+
+    /** cos w and cos 2w at every point, so a section's response is plain arithmetic. */
+    struct Grid
+    {
+        explicit Grid (double sampleRate)
+        {
+            for (int i = 0; i < MatchEQ::numPoints; ++i)
+            {
+                auto omega = juce::MathConstants<double>::twoPi * MatchEQ::getFrequency (i) / sampleRate;
+                cosW[(size_t) i] = std::cos (omega);
+                cos2W[(size_t) i] = std::cos (2.0 * omega);
+            }
+        }
+
+        void getResponseDb (const BiquadCoefficients& c, int numValid, double* dest) const noexcept
+        {
+            // |H|^2 from the same expansion as ResponseCurve::evaluate
+            auto num0 = c.b0 * c.b0 + c.b1 * c.b1 + c.b2 * c.b2;
+            auto num1 = 2.0 * (c.b0 * c.b1 + c.b1 * c.b2);
+            auto num2 = 2.0 * c.b0 * c.b2;
+            auto den0 = 1.0 + c.a1 * c.a1 + c.a2 * c.a2;
+            auto den1 = 2.0 * (c.a1 + c.a1 * c.a2);
+            auto den2 = 2.0 * c.a2;
+
+            for (size_t i = 0; i < (size_t) numValid; ++i)
+            {
+                auto numerator = num0 + num1 * cosW[i] + num2 * cos2W[i];
+                auto denominator = den0 + den1 * cosW[i] + den2 * cos2W[i];
+                dest[i] = 10.0 * std::log10 (juce::jmax (1.0e-20, numerator) / juce::jmax (1.0e-20, denominator));
+            }
+        }
+
+        std::array<double, MatchEQ::numPoints> cosW, cos2W;
+    };
+
+    using Curve = std::array<double, MatchEQ::numPoints>;
+
+    /** Pattern search over log frequency, gain and log Q for one band against what the
+        other bands left over. Returns the weighted mean square error it ends on. */
+    double optimise (MatchEQ::Band& band, const Curve& residual, const Curve& weights, int numValid,
+                     double sampleRate, const Grid& grid, Curve& response)
+    {
+        auto hasGain = FilterDesign::hasGain (band.type);
+        auto maxFrequency = juce::jmin (20000.0, sampleRate * 0.45);
+        double weightSum = 0.0;
+
+        for (int i = 0; i < numValid; ++i)
+            weightSum += weights[(size_t) i];
+
+        auto evaluate = [&] (const MatchEQ::Band& b, Curve& dest)
+        {
+            grid.getResponseDb (FilterDesign::design (b.type, sampleRate, b.frequency, b.q, b.gainDb), numValid, dest.data());
+            double error = 0.0;
+
+            for (size_t i = 0; i < (size_t) numValid; ++i)
+                error += weights[i] * (residual[i] - dest[i]) * (residual[i] - dest[i]);
+
+            return weightSum > 0.0 ? error / weightSum : 0.0;
+        };
+
+        auto clamp = [&] (MatchEQ::Band& b)
+        {
+            b.frequency = juce::jlimit (30.0, maxFrequency, b.frequency);
+            b.gainDb = hasGain ? juce::jlimit (-10.0, 10.0, b.gainDb) : 0.0;
+            b.q = juce::jlimit (0.1, 18.0, b.q);
+        };
+
+        clamp (band);
+        auto error = evaluate (band, response);
+        Curve candidateResponse;
+
+        // steps in octaves of frequency, dB and octaves of Q
+        double steps[] = { 1.0 / 3.0, 1.0, 0.5 };
+
+        for (int iteration = 0; iteration < 200 && steps[0] > 1.0 / 96.0; ++iteration)
+        {
+            auto improved = false;
+
+            for (int parameter = 0; parameter < 3; ++parameter)
+            {
+                if (parameter == 1 && ! hasGain)
+                    continue;
+
+                for (auto direction : { 1.0, -1.0 })
+                {
+                    auto candidate = band;
+                    auto step = direction * steps[parameter];
+
+                    if (parameter == 0)         candidate.frequency *= std::exp2 (step);
+                    else if (parameter == 1)    candidate.gainDb += step;
+                    else                        candidate.q *= std::exp2 (step);
+
+                    clamp (candidate);
+                    auto candidateError = evaluate (candidate, candidateResponse);
+
+                    if (candidateError < error)
+                    {
+                        band = candidate;
+                        error = candidateError;
+                        response = candidateResponse;
+                        improved = true;
+                        break;
+                    }
+                }
+            }
+
+            if (! improved)
+                for (auto& s : steps)
+                    s *= 0.5;
+        }
+
+        return error;
+    }
+}
+
+//==============================================================================
+double MatchEQ::getFrequency (int point) noexcept
+{
+    return lowestFrequency * std::exp2 ((double) point / pointsPerOctave);
+}
+
+juce::Result MatchEQ::analyse (const juce::File& file, juce::AudioFormatManager& formats, int numThreads,
+                               Spectrum& dest, std::function<bool()> shouldExit)
+{
+    std::unique_ptr<juce::AudioFormatReader> probe (formats.createReaderFor (file));
+    if (probe == nullptr)
+        return juce::Result::fail ("Couldn't read " + file.getFullPathName());
+
+    auto length = probe->lengthInSamples;
+    auto sampleRate = probe->sampleRate;
+
+    if (length <= 0 || sampleRate <= 0.0 || probe->numChannels == 0)
+        return juce::Result::fail (file.getFileName() + " is empty");
+
+    // every frame starts a hop after the last one, the final one runs past the end into silence
+    auto numFrames = juce::jmax ((juce::int64) 1, (length - fftSize + hopSize - 1) / hopSize + 1);
+    auto numWorkers = (int) juce::jlimit ((juce::int64) 1, numFrames, (juce::int64) numThreads);
+    juce::OwnedArray<ChunkWorker> workers;
+
+    // readers aren't thread safe, so every worker gets its own, created here
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* reader = i == 0 ? probe.release() : formats.createReaderFor (file);
+        if (reader == nullptr)
+            return juce::Result::fail ("Couldn't read " + file.getFullPathName());
+
+        workers.add (new ChunkWorker (reader, numFrames * i / numWorkers, numFrames * (i + 1) / numWorkers, shouldExit));
+    }
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit (-1);
+
+    std::vector<double> power ((size_t) fftSize / 2 + 1, 0.0);
+
+    for (auto* worker : workers)
+    {
+        if (! worker->finished)
+            return juce::Result::fail ("Cancelled");
+
+        for (size_t k = 0; k < power.size(); ++k)
+            power[k] += worker->power[k];
+    }
+
+    if (std::all_of (power.begin(), power.end(), [] (double p) { return p <= 0.0; }))
+        return juce::Result::fail (file.getFileName() + " is silent");
+
+    // average power over each point's share of an octave, so single bins and harmonics don't count on their own
+    auto binsPerHz = fftSize / sampleRate;
+    auto halfWidth = std::exp2 (smoothingOctaves * 0.5);
+    dest.numValid = 0;
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        auto frequency = getFrequency (i);
+        if (frequency * halfWidth >= sampleRate * 0.5)
+            break;
+
+        auto first = (size_t) std::ceil (frequency / halfWidth * binsPerHz);
+        auto last = (size_t) std::floor (frequency * halfWidth * binsPerHz);
+
+        if (last < first)
+            first = last = (size_t) juce::roundToInt (frequency * binsPerHz);
+
+        double sum = 0.0;
+        for (auto k = first; k <= last; ++k)
+            sum += power[k];
+
+        dest.levelDb[(size_t) i] = (float) (10.0 * std::log10 (juce::jmax (1.0e-30, sum / (double) (last - first + 1) / (double) numFrames)));
+        dest.numValid = i + 1;
+    }
+
+    dest.sampleRate = sampleRate;
+    dest.lengthInSamples = length;
+    return juce::Result::ok();
+}
+
+MatchEQ::Result MatchEQ::fit (const Spectrum& reference, const Spectrum& target, double sampleRate)
+{
+    Result result;
+    auto numValid = juce::jmin (reference.numValid, target.numValid);
+
+    while (numValid > 0 && getFrequency (numValid - 1) >= sampleRate * 0.45)
+        --numValid;
+
+    if (numValid == 0 || sampleRate <= 0.0)
+        return result;
+
+    // points where either file has next to nothing would only ask for huge boosts
+    auto floorDb = [numValid] (const Spectrum& s)
+    {
+        return *std::max_element (s.levelDb.begin(), s.levelDb.begin() + numValid) - 60.f;
+    };
+
+    auto referenceFloor = floorDb (reference), targetFloor = floorDb (target);
+    Curve difference {}, weights {};
+    double weightSum = 0.0, mean = 0.0;
+
+    for (size_t i = 0; i < (size_t) numValid; ++i)
+    {
+        weights[i] = reference.levelDb[i] > referenceFloor && target.levelDb[i] > targetFloor ? 1.0 : 0.0;
+        difference[i] = reference.levelDb[i] - target.levelDb[i];
+        weightSum += weights[i];
+        mean += weights[i] * difference[i];
+    }
+
+    if (weightSum <= 0.0)
+        return result;
+
+    // only the shape is matched; the level is left to the fader, or to auto gain
+    mean /= weightSum;
+    for (size_t i = 0; i < (size_t) numValid; ++i)
+        difference[i] -= mean;
+
+    Grid grid (sampleRate);
+    std::array<Curve, ParameterIDs::numBands> responses;
+    Curve total {}, residual {}, response {};
+
+    auto getError = [&]
+    {
+        double error = 0.0;
+        for (size_t i = 0; i < (size_t) numValid; ++i)
+            error += weights[i] * (difference[i] - total[i]) * (difference[i] - total[i]);
+
+        return error / weightSum;
+    };
+
+    auto error = getError();
+    result.initialErrorDb = std::sqrt (error);
+
+    // one band at a time, where the remaining error is worst
+    while (result.numBands < ParameterIDs::numBands && std::sqrt (error) > 0.25)
+    {
+        for (size_t i = 0; i < (size_t) numValid; ++i)
+            residual[i] = difference[i] - total[i];
+
+        // peaks start from the biggest bumps and dips left, the other types from where they usually sit
+        std::vector<Band> candidates;
+        std::vector<std::pair<double, int>> extremes;
+
+        for (int i = 0; i < numValid; ++i)
+        {
+            auto r = residual[(size_t) i];
+            auto before = i > 0 ? residual[(size_t) i - 1] : -r;
+            auto after = i < numValid - 1 ? residual[(size_t) i + 1] : -r;
+
+            if (weights[(size_t) i] > 0.0 && ((r >= before && r >= after) || (r <= before && r <= after)))
+                extremes.push_back ({ std::abs (r), i });
+        }
+
+        std::sort (extremes.begin(), extremes.end(), std::greater<std::pair<double, int>>());
+
+        for (size_t e = 0; e < juce::jmin ((size_t) maxPeakCandidates, extremes.size()); ++e)
+        {
+            auto point = extremes[e].second;
+            candidates.push_back ({ FilterDesign::peak, getFrequency (point), residual[(size_t) point], 1.0 });
+        }
+
+        candidates.push_back ({ FilterDesign::lowShelf, 150.0, residual[0], 0.707 });
+        candidates.push_back ({ FilterDesign::highShelf, 6000.0, residual[(size_t) numValid - 1], 0.707 });
+        candidates.push_back ({ FilterDesign::highPass, 30.0, 0.0, 0.707 });
+        candidates.push_back ({ FilterDesign::lowPass, 20000.0, 0.0, 0.707 });
+
+        Band best;
+        auto bestError = error;
+
+        for (auto band : candidates)
+        {
+            auto bandError = optimise (band, residual, weights, numValid, sampleRate, grid, response);
+
+            if (bandError < bestError)
+            {
+                best = band;
+                bestError = bandError;
+                responses[(size_t) result.numBands] = response;
+            }
+        }
+
+        // nothing left that a band can take out
+        if (bestError > error * 0.99)
+            break;
+
+        auto& added = responses[(size_t) result.numBands];
+        for (size_t i = 0; i < (size_t) numValid; ++i)
+            total[i] += added[i];
+
+        result.bands[(size_t) result.numBands++] = best;
+        error = bestError;
+    }
+
+    // every band again against what all the others now leave over
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int b = 0; b < result.numBands; ++b)
+        {
+            auto& previous = responses[(size_t) b];
+            for (size_t i = 0; i < (size_t) numValid; ++i)
+                residual[i] = difference[i] - total[i] + previous[i];
+
+            optimise (result.bands[(size_t) b], residual, weights, numValid, sampleRate, grid, response);
+
+            for (size_t i = 0; i < (size_t) numValid; ++i)
+                total[i] += response[i] - previous[i];
+
+            previous = response;
+        }
+    }
+
+    result.errorDb = std::sqrt (getError());
+    return result;
+}
+
+void MatchEQ::apply (const Result& result, juce::AudioProcessorValueTreeState& parameters)
+{
+    auto set = [&parameters] (const char* name, int band, double value)
+    {
+        if (auto* param = parameters.getParameter (ParameterIDs::band (name, band)))
+            param->setValueNotifyingHost (param->convertTo0to1 ((float) value));
+    };
+
+    for (int i = 0; i < ParameterIDs::numBands; ++i)
+    {
+        set (ParameterIDs::enabled, i, i < result.numBands ? 1.0 : 0.0);
+
+        if (i >= result.numBands)
+            continue;
+
+        // the fit used plain second order sections on every channel, which is what these settings run
+        auto& band = result.bands[(size_t) i];
+        set (ParameterIDs::type, i, band.type);
+        set (ParameterIDs::freq, i, band.frequency);
+        set (ParameterIDs::gain, i, band.gainDb);
+        set (ParameterIDs::q, i, band.q);
+        set (ParameterIDs::slope, i, 1.0);
+        set (ParameterIDs::channels, i, 0.0);
+        set (ParameterIDs::routing, i, 0.0);
+        set (ParameterIDs::dynamic, i, 0.0);
+    }
+}
+
+//==============================================================================
+MatchEQ::Job::Job (const juce::File& referenceFile, const juce::File& targetFile, double sampleRate)
+    : juce::Thread ("PhaseEQ Match EQ"), reference (referenceFile), target (targetFile), designRate (sampleRate)
+{
+}
+
+MatchEQ::Job::~Job()
+{
+    stopThread (4000);
+}
+
+void MatchEQ::Job::run()
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto numThreads = juce::jmax (1, juce::SystemStats::getNumCpus() - 1);
+    std::function<bool()> shouldExit = [this] { return threadShouldExit(); };
+    Spectrum referenceSpectrum, targetSpectrum;
+
+    status = analyse (reference, formats, numThreads, referenceSpectrum, shouldExit);
+
+    if (status.wasOk())
+        status = analyse (target, formats, numThreads, targetSpectrum, shouldExit);
+
+    if (status.wasOk())
+        result = fit (referenceSpectrum, targetSpectrum, designRate);
+}
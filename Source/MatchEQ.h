@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    MatchEQ.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterDesign.h"
+#include "ParameterIDs.h"
+
+//==============================================================================
+/**
+    Match EQ: the bands that make a target file sound like a reference file,
+    as parameter values for the processor.
+
+    analyse() streams a file through averaged, Hann windowed FFTs. The file is
+    cut into one contiguous range per thread, and each thread reads its range
+    with a reader of its own, one hop at a time, so memory stays at a few FFT
+    frames per thread however long the file is. The average power is then
+    smoothed to smoothingOctaves at pointsPerOctave points.
+
+    fit() takes the reference minus the target, without its average level, and
+    places up to ParameterIDs::numBands bands of the existing filter types one at
+    a time. Peaks are tried at the biggest bumps and dips still left, the
+    shelves and pass filters where they usually sit, and a pattern search tunes
+    each candidate; the one that reduces the error most is kept. All bands are
+    then refined again against each other. Every value stays inside the
+    parameter ranges.
+*/
+class MatchEQ
+{
+public:
+    static constexpr int fftOrder = 13;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr double lowestFrequency = 20.0;
+    static constexpr int pointsPerOctave = 24;
+    static constexpr int numPoints = 10 * pointsPerOctave;         // 20 Hz to 20 kHz
+    static constexpr double smoothingOctaves = 1.0 / 3.0;
+    static constexpr int maxPeakCandidates = 4;                    // per band placed by fit()
+
+    static double getFrequency (int point) noexcept;
+
+    /** Smoothed level of a file at each point; only the first numValid reach below its Nyquist. */
+    struct Spectrum
+    {
+        std::array<float, numPoints> levelDb {};
+        int numValid = 0;
+        double sampleRate = 0.0;
+        juce::int64 lengthInSamples = 0;
+    };
+
+    /** Fills dest from the file, using up to numThreads readers at once. shouldExit is
+        polled between hops and makes it fail early. */
+    static juce::Result analyse (const juce::File& file, juce::AudioFormatManager& formats, int numThreads,
+                                 Spectrum& dest, std::function<bool()> shouldExit = nullptr);
+
+    struct Band
+    {
+        int type = FilterDesign::peak;
+        double frequency = 1000.0, gainDb = 0.0, q = 0.707;
+    };
+
+    struct Result
+    {
+        std::array<Band, ParameterIDs::numBands> bands;
+        int numBands = 0;
+        double initialErrorDb = 0.0, errorDb = 0.0;    // RMS over the points that count, before and after
+    };
+
+    /** The bands that take target towards reference, designed at sampleRate. */
+    static Result fit (const Spectrum& reference, const Spectrum& target, double sampleRate);
+
+    /** Sets the bands' parameters and switches every other band off. Message thread,
+        or whichever thread owns the processor when there is no host. */
+    static void apply (const Result& result, juce::AudioProcessorValueTreeState& parameters);
+
+    //==============================================================================
+    /** Analyses both files and fits them on a thread of its own, for the editor. */
+    class Job  : public juce::Thread
+    {
+    public:
+        Job (const juce::File& referenceFile, const juce::File& targetFile, double sampleRate);
+        ~Job() override;
+
+        void run() override;
+
+        /** Once the thread has finished. */
+        const juce::Result& getStatus() const noexcept       { return status; }
+        const Result& getResult() const noexcept              { return result; }
+
+    private:
+        juce::File reference, target;
+        double designRate;
+        juce::Result status { juce::Result::fail ("not run") };
+        Result result;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Job)
+    };
+};
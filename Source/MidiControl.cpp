@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+    MidiControl.cpp
+
+  ==============================================================================
+*/
+
+#include "MidiControl.h"
+
+//==============================================================================
+MidiControl::MidiControl (juce::AudioProcessorValueTreeState& parameters)
+{
+    const char* targetIDs[numTargets] = { ParameterIDs::freq, ParameterIDs::gain, ParameterIDs::q };
+
+    for (int band = 0; band < ParameterIDs::numBands; ++band)
+    {
+        for (int target = 0; target < numTargets; ++target)
+        {
+            auto id = ParameterIDs::band (targetIDs[target], band);
+            auto mapping = (size_t) getMapping (band, target);
+
+            mappedParameters[mapping] = parameters.getParameter (id);
+            rawValues[mapping] = parameters.getRawParameterValue (id);
+            pendingValues[mapping] = -1.f;
+        }
+    }
+
+    clear();
+    startTimer (notifyIntervalMs);
+}
+
+MidiControl::~MidiControl()
+{
+    stopTimer();
+}
+
+void MidiControl::forget (int mapping) noexcept
+{
+    for (auto& c : controllers)
+    {
+        auto expected = mapping;
+        c.compare_exchange_strong (expected, -1);
+    }
+}
+
+void MidiControl::clear() noexcept
+{
+    for (auto& c : controllers)
+        c = -1;
+
+    learning = -1;
+}
+
+int MidiControl::getController (int mapping) const noexcept
+{
+    for (int i = 0; i < numControllers; ++i)
+        if (controllers[(size_t) i].load() == mapping)
+            return i;
+
+    return -1;
+}
+
+bool MidiControl::isMapped (int controller) const noexcept
+{
+    return learning.load() >= 0 || (juce::isPositiveAndBelow (controller, numControllers) && controllers[(size_t) controller].load() >= 0);
+}
+
+int MidiControl::handleController (const juce::MidiMessage& message) noexcept
+{
+    auto controller = message.getControllerNumber();
+    if (! message.isController() || ! juce::isPositiveAndBelow (controller, numControllers))
+        return -1;
+
+    auto armed = learning.load();
+    if (armed >= 0 && learning.compare_exchange_strong (armed, -1))
+    {
+        forget (armed);
+        controllers[(size_t) controller] = armed;
+    }
+
+    auto mapping = controllers[(size_t) controller].load();
+    if (! juce::isPositiveAndBelow (mapping, numMappings) || mappedParameters[(size_t) mapping] == nullptr
+         || rawValues[(size_t) mapping] == nullptr)
+        return -1;
+
+    // the full controller range covers the parameter's normalised range, skew included
+    auto value = (float) message.getControllerValue() / 127.f;
+    rawValues[(size_t) mapping]->store (mappedParameters[(size_t) mapping]->convertFrom0to1 (value));
+    pendingValues[(size_t) mapping] = value;
+    return mapping / numTargets;
+}
+
+void MidiControl::flushPendingValues()
+{
+    // only the latest value of each parameter since the last flush reaches the host
+    for (size_t i = 0; i < (size_t) numMappings; ++i)
+    {
+        auto value = pendingValues[i].exchange (-1.f);
+        auto* parameter = mappedParameters[i];
+
+        if (value < 0.f || parameter == nullptr)
+            continue;
+
+        parameter->beginChangeGesture();
+        parameter->setValueNotifyingHost (value);
+        parameter->endChangeGesture();
+    }
+}
+
+void MidiControl::timerCallback()
+{
+    flushPendingValues();
+}
+
+void MidiControl::writeTo (juce::OutputStream& stream) const
+{
+    auto numMapped = 0;
+    for (auto& c : controllers)
+        numMapped += c.load() >= 0 ? 1 : 0;
+
+    stream.writeCompressedInt (numMapped);
+
+    for (int i = 0; i < numControllers; ++i)
+    {
+        auto mapping = controllers[(size_t) i].load();
+
+        if (mapping >= 0)
+        {
+            stream.writeCompressedInt (i);
+            stream.writeCompressedInt (mapping);
+        }
+    }
+}
+
+void MidiControl::readFrom (juce::InputStream& stream)
+{
+    clear();
+
+    auto numMapped = stream.readCompressedInt();
+
+    for (int i = 0; i < numMapped && ! stream.isExhausted(); ++i)
+    {
+        auto controller = stream.readCompressedInt();
+        auto mapping = stream.readCompressedInt();
+
+        if (juce::isPositiveAndBelow (controller, numControllers) && juce::isPositiveAndBelow (mapping, numMappings))
+            controllers[(size_t) controller] = mapping;
+    }
+}
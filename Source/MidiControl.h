@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    MidiControl.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterIDs.h"
+
+//==============================================================================
+/**
+    MIDI CC mapping for the band parameters that can move between any two
+    samples: FREQ, GAIN and Q.
+
+    Each controller number drives at most one parameter, and each parameter is
+    driven by at most one controller. learn() arms a parameter, and the next
+    controller that arrives on the audio thread is mapped to it.
+
+    The map is a fixed array of atomics, so processBlock reads and updates it
+    without locking or allocating, while the editor changes it at any time.
+
+    A controller only writes the raw value the designer reads, so the change
+    takes effect on the audio thread right away. The parameter itself, with
+    the host and the editor listening to it, catches up on the message thread
+    at the next timer tick: notifying the host from processBlock can block.
+    Until then the parameter's own value, which is what the host automates and
+    what the plugin state saves, lags what is playing by up to one tick, so
+    the state is saved only after flushPendingValues().
+*/
+class MidiControl  : private juce::Timer
+{
+public:
+    explicit MidiControl (juce::AudioProcessorValueTreeState& parameters);
+    ~MidiControl() override;
+
+    /** What a controller can drive, per band. */
+    enum Target
+    {
+        freq = 0,
+        gain,
+        q,
+        numTargets
+    };
+
+    static constexpr int numControllers = 128;
+    static constexpr int numMappings = ParameterIDs::numBands * numTargets;
+
+    static int getMapping (int band, int target) noexcept       { return band * numTargets + target; }
+
+    /** The next controller to arrive gets mapped to this one, replacing whatever
+        drove it before. -1 stops listening. */
+    void learn (int mapping) noexcept                            { learning = mapping; }
+    int getLearning() const noexcept                             { return learning.load(); }
+
+    void forget (int mapping) noexcept;
+    void clear() noexcept;
+
+    /** Controller number that drives the mapping, or -1. */
+    int getController (int mapping) const noexcept;
+
+    /** True if the controller would change a parameter, which includes any controller
+        while learning. */
+    bool isMapped (int controller) const noexcept;
+
+    /** Audio thread: learns the controller if armed, then sets the raw value of the
+        parameter it drives and leaves the rest to the message thread. Returns the band
+        whose parameter changed, or -1. */
+    int handleController (const juce::MidiMessage& message) noexcept;
+
+    /** Hands the latest controller value of each parameter on to the parameter, as one
+        gesture, which notifies the host. Runs on a timer on the message thread; the
+        processor also calls it before saving its state, so a controller that moved
+        since the last tick isn't left out. Never from the audio thread. */
+    void flushPendingValues();
+
+    /** The map as saved with the plugin state. */
+    void writeTo (juce::OutputStream& stream) const;
+    void readFrom (juce::InputStream& stream);
+
+private:
+    void timerCallback() override;
+
+    std::array<std::atomic<int>, numControllers> controllers;    // mapping per controller, -1 for none
+    std::array<juce::RangedAudioParameter*, numMappings> mappedParameters;
+    std::array<std::atomic<float>*, numMappings> rawValues;
+    std::array<std::atomic<float>, numMappings> pendingValues;   // normalised, -1 for none
+    std::atomic<int> learning { -1 };
+
+    static constexpr int notifyIntervalMs = 20;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiControl)
+};
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    Oversampler.cpp
+
+  ==============================================================================
+*/
+
+#include "Oversampler.h"
+
+//==============================================================================
+template <typename SampleType>
+std::unique_ptr<juce::dsp::Oversampling<SampleType>> Oversampler<SampleType>::createStage (size_t numChannels, int stageOrder, int stageQuality)
+{
+    using Stage = juce::dsp::Oversampling<SampleType>;
+    auto filterType = stageQuality == linearPhase ? Stage::filterHalfBandFIREquiripple
+                                                  : Stage::filterHalfBandPolyphaseIIR;
+
+    // integer latency so the host can compensate it exactly
+    return std::make_unique<Stage> (numChannels, (size_t) stageOrder, filterType, true, true);
+}
+
+template <typename SampleType>
+int Oversampler<SampleType>::getLatencySamples (int stageOrder, int stageQuality)
+{
+    // the latency only depends on the filter design, so one mono instance of each is enough
+    static const auto latencies = []
+    {
+        std::array<int, (size_t) (maxOrder * numQualities)> result {};
+
+        for (int o = 1; o <= maxOrder; ++o)
+            for (int q = 0; q < numQualities; ++q)
+                result[(size_t) ((o - 1) * numQualities + q)] = juce::roundToInt (createStage (1, o, q)->getLatencyInSamples());
+
+        return result;
+    }();
+
+    if (stageOrder <= 0 || stageOrder > maxOrder || ! juce::isPositiveAndBelow (stageQuality, (int) numQualities))
+        return 0;
+
+    return latencies[(size_t) ((stageOrder - 1) * numQualities + stageQuality)];
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    maxBlockSize = (size_t) spec.maximumBlockSize;
+
+    for (int o = 1; o <= maxOrder; ++o)
+    {
+        for (int q = 0; q < numQualities; ++q)
+        {
+            auto& stage = stages[(size_t) ((o - 1) * numQualities + q)];
+            stage = createStage ((size_t) spec.numChannels, o, q);
+            stage->initProcessing (maxBlockSize);
+        }
+    }
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::reset() noexcept
+{
+    for (auto& stage : stages)
+        if (stage != nullptr)
+            stage->reset();
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::setMode (int newOrder, int newQuality) noexcept
+{
+    newOrder = juce::jlimit (0, maxOrder, newOrder);
+    newQuality = juce::jlimit (0, (int) numQualities - 1, newQuality);
+
+    if (newOrder == order && newQuality == quality)
+        return;
+
+    order = newOrder;
+    quality = newQuality;
+
+    if (auto* stage = getStage())
+        stage->reset();
+}
+
+template <typename SampleType>
+juce::dsp::Oversampling<SampleType>* Oversampler<SampleType>::getStage() const noexcept
+{
+    if (order <= 0)
+        return nullptr;
+
+    return stages[(size_t) ((order - 1) * numQualities + quality)].get();
+}
+
+//==============================================================================
+template class Oversampler<float>;
+template class Oversampler<double>;
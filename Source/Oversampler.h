@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Runs the minimum phase cascade at 2x, 4x or 8x the host rate, so that peaks
+    and shelves near Nyquist aren't squeezed by the bilinear transform.
+
+    Every order/quality combination is built in prepare(), which means switching
+    on the audio thread only picks another stage and clears it. SampleType is
+    float or double.
+*/
+template <typename SampleType>
+class Oversampler
+{
+public:
+    Oversampler() = default;
+
+    static constexpr int maxOrder = 3;
+
+    enum Quality
+    {
+        efficient = 0,  // polyphase IIR half-band stages: cheap, minimum phase
+        linearPhase,    // equiripple FIR half-band stages: costlier, adds more latency
+        numQualities
+    };
+
+    /** Latency at the host rate, the same for both precisions; allocates on first
+        use, so call it off the audio thread. */
+    static int getLatencySamples (int order, int quality);
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    /** Audio thread: switches stage and clears it if the mode changed. */
+    void setMode (int newOrder, int newQuality) noexcept;
+    int getOrder() const noexcept       { return order; }
+    int getQuality() const noexcept     { return quality; }
+
+    /** Upsamples block, calls processOversampled with the oversampled block and
+        downsamples the result back into block. */
+    template <typename Callback>
+    void process (juce::dsp::AudioBlock<SampleType>& block, Callback&& processOversampled) noexcept
+    {
+        auto* stage = getStage();
+        if (stage == nullptr)
+        {
+            processOversampled (block);
+            return;
+        }
+
+        // the stages are sized for the announced block size only
+        for (size_t start = 0; start < block.getNumSamples(); start += maxBlockSize)
+        {
+            auto subBlock = block.getSubBlock (start, juce::jmin (maxBlockSize, block.getNumSamples() - start));
+            auto oversampled = stage->processSamplesUp (subBlock);
+            processOversampled (oversampled);
+            stage->processSamplesDown (subBlock);
+        }
+    }
+
+private:
+    static std::unique_ptr<juce::dsp::Oversampling<SampleType>> createStage (size_t numChannels, int order, int quality);
+    juce::dsp::Oversampling<SampleType>* getStage() const noexcept;
+
+    std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, (size_t) (maxOrder * numQualities)> stages;
+    size_t maxBlockSize = 0;
+    int order = 0, quality = efficient;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oversampler)
+};
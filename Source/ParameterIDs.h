@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    ParameterIDs.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+namespace ParameterIDs
+{
+    constexpr int numBands = 8;
+
+    /** Per band parameters are stored as e.g. "FREQ_1" ... "FREQ_8". */
+    inline juce::String band (const char* name, int bandIndex)
+    {
+        return juce::String (name) + "_" + juce::String (bandIndex + 1);
+    }
+
+    constexpr const char* enabled  = "ENABLED";
+    constexpr const char* type     = "FILTERS";
+    constexpr const char* freq     = "FREQ";
+    constexpr const char* gain     = "GAIN";
+    constexpr const char* q        = "Q";
+    constexpr const char* channels = "CHANNELS";
+    constexpr const char* routing  = "ROUTING";
+
+    constexpr const char* slope          = "SLOPE";
+    constexpr const char* characteristic = "CHARACTERISTIC";
+
+    constexpr const char* dynamic   = "DYNAMIC";
+    constexpr const char* threshold = "THRESHOLD";
+    constexpr const char* ratio     = "RATIO";
+    constexpr const char* attack    = "ATTACK";
+    constexpr const char* release   = "RELEASE";
+    constexpr const char* sidechain = "SIDECHAIN";
+
+    constexpr const char* smoothing           = "SMOOTHING";
+    constexpr const char* controlInterval     = "CONTROL_INTERVAL";
+    constexpr const char* phaseMode           = "PHASE_MODE";
+    constexpr const char* correctionLow       = "CORRECTION_LOW";
+    constexpr const char* correctionHigh      = "CORRECTION_HIGH";
+    constexpr const char* oversampling        = "OVERSAMPLING";
+    constexpr const char* oversamplingQuality = "OVERSAMPLING_QUALITY";
+    constexpr const char* autoGain            = "AUTO_GAIN";
+}
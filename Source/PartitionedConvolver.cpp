@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "PartitionedConvolver.h"
+
+//==============================================================================
+namespace
+{
+    int getOrder (int size) noexcept
+    {
+        int order = 0;
+        while ((1 << order) < size)
+            ++order;
+        return order;
+    }
+
+    /** acc += x * h over numBins interleaved complex values, written out so it vectorises. */
+    void multiplyAccumulate (float* acc, const float* x, const float* h, int numBins) noexcept
+    {
+        for (int k = 0; k < numBins * 2; k += 2)
+        {
+            auto re = x[k] * h[k] - x[k + 1] * h[k + 1];
+            auto im = x[k] * h[k + 1] + x[k + 1] * h[k];
+            acc[k] += re;
+            acc[k + 1] += im;
+        }
+    }
+}
+
+//==============================================================================
+int PartitionedConvolver::getKernelLength (double sampleRate) noexcept
+{
+    return juce::jmax (partitionSize * 2, juce::nextPowerOfTwo ((int) (sampleRate * 0.17)));
+}
+
+int PartitionedConvolver::getLatencySamples (double sampleRate) noexcept
+{
+    return getKernelLength (sampleRate) / 2 + partitionSize;
+}
+
+void PartitionedConvolver::prepare (const juce::dsp::ProcessSpec& spec)
+{
+    numChannels = (size_t) spec.numChannels;
+    numPartitions = getKernelLength (spec.sampleRate) / partitionSize;
+    numBins = partitionSize + 1;
+
+    fft = std::make_unique<juce::dsp::FFT> (getOrder (partitionSize * 2));
+
+    delayLine.assign (numChannels * (size_t) (numPartitions * numBins), {});
+    inputFrames.setSize ((int) numChannels, partitionSize * 2);
+    outputFrames.setSize ((int) numChannels, partitionSize);
+    fftBuffer.assign ((size_t) partitionSize * 4, 0.f);
+    fadeBuffer.assign ((size_t) partitionSize, 0.f);
+    accumulator.assign ((size_t) numBins, {});
+
+    // until the first real kernel arrives, pass the signal through with the same delay:
+    // an impulse at the kernel centre, which always starts a partition, has a flat spectrum
+    auto kernel = std::make_shared<ConvolutionKernel>();
+    kernel->partitionSize = partitionSize;
+    kernel->numPartitions = numPartitions;
+    kernel->spectra.assign ((size_t) (numPartitions * numBins), {});
+
+    auto centrePartition = (size_t) (numPartitions / 2);
+    std::fill (kernel->spectra.begin() + (long) (centrePartition * (size_t) numBins),
+               kernel->spectra.begin() + (long) ((centrePartition + 1) * (size_t) numBins),
+               std::complex<float> (1.f));
+
+    passthrough = std::move (kernel);
+    currentKernel = passthrough;
+    nextKernel.reset();
+    fadePending = false;
+    reset();
+}
+
+void PartitionedConvolver::reset() noexcept
+{
+    std::fill (delayLine.begin(), delayLine.end(), std::complex<float>());
+    inputFrames.clear();
+    outputFrames.clear();
+    framePosition = 0;
+    delayLineIndex = 0;
+}
+
+void PartitionedConvolver::setKernel (const std::shared_ptr<const ConvolutionKernel>& kernel) noexcept
+{
+    if (kernel == nullptr || kernel->partitionSize != partitionSize || kernel->numPartitions != numPartitions
+         || kernel->spectra.size() != (size_t) (numPartitions * numBins))
+        return;
+
+    nextKernel = kernel;
+    fadePending = true;
+}
+
+void PartitionedConvolver::process (const juce::dsp::ProcessContextReplacing<float>& context) noexcept
+{
+    auto& block = context.getOutputBlock();
+    auto numSamples = block.getNumSamples();
+    auto channels = juce::jmin (numChannels, block.getNumChannels());
+
+    if (context.isBypassed || numPartitions == 0)
+        return;
+
+    for (size_t done = 0; done < numSamples;)
+    {
+        auto count = juce::jmin (numSamples - done, (size_t) (partitionSize - framePosition));
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            auto* data = block.getChannelPointer (ch) + done;
+            auto* in = inputFrames.getWritePointer ((int) ch, partitionSize + framePosition);
+            auto* out = outputFrames.getReadPointer ((int) ch, framePosition);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                in[i] = data[i];
+                data[i] = out[i];
+            }
+        }
+
+        framePosition += (int) count;
+        done += count;
+
+        if (framePosition == partitionSize)
+        {
+            processFrame();
+            framePosition = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processFrame() noexcept
+{
+    auto* fftData = fftBuffer.data();
+    auto* acc = reinterpret_cast<float*> (accumulator.data());
+
+    auto convolve = [&] (size_t ch, const ConvolutionKernel& kernel)
+    {
+        std::fill (accumulator.begin(), accumulator.end(), std::complex<float>());
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            auto index = (delayLineIndex - p + numPartitions) % numPartitions;
+            auto* x = delayLine.data() + (ch * (size_t) numPartitions + (size_t) index) * (size_t) numBins;
+            auto* h = kernel.spectra.data() + (size_t) (p * numBins);
+
+            multiplyAccumulate (acc, reinterpret_cast<const float*> (x), reinterpret_cast<const float*> (h), numBins);
+        }
+
+        std::copy (acc, acc + numBins * 2, fftData);
+        fft->performRealOnlyInverseTransform (fftData);
+        return fftData + partitionSize; // overlap-save: only the second half is valid
+    };
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* frame = inputFrames.getWritePointer ((int) ch);
+
+        std::copy (frame, frame + partitionSize * 2, fftData);
+        std::fill (fftData + partitionSize * 2, fftData + partitionSize * 4, 0.f);
+        fft->performRealOnlyForwardTransform (fftData, true);
+
+        auto* spectrum = reinterpret_cast<const std::complex<float>*> (fftData);
+        std::copy (spectrum, spectrum + numBins,
+                   delayLine.begin() + (long) ((ch * (size_t) numPartitions + (size_t) delayLineIndex) * (size_t) numBins));
+
+        auto* out = outputFrames.getWritePointer ((int) ch);
+
+        if (fadePending)
+        {
+            auto* previous = convolve (ch, *currentKernel);
+            std::copy (previous, previous + partitionSize, fadeBuffer.begin());
+
+            auto* next = convolve (ch, *nextKernel);
+            for (int i = 0; i < partitionSize; ++i)
+            {
+                auto w = (float) (i + 1) / (float) partitionSize;
+                out[i] = fadeBuffer[(size_t) i] + w * (next[i] - fadeBuffer[(size_t) i]);
+            }
+        }
+        else
+        {
+            auto* result = convolve (ch, *currentKernel);
+            std::copy (result, result + partitionSize, out);
+        }
+
+        std::copy (frame + partitionSize, frame + partitionSize * 2, frame);
+    }
+
+    if (fadePending)
+    {
+        // only a reference count drops here: the kernel let go of is still held by
+        // whoever published it, and freed on their side
+        currentKernel = std::move (nextKernel);
+        fadePending = false;
+    }
+
+    delayLineIndex = (delayLineIndex + 1) % numPartitions;
+}
+
+//==============================================================================
+void makeLinearPhaseKernel (const CascadeSetup& setup, double sampleRate, ConvolutionKernel& kernel)
+{
+    constexpr auto partitionSize = PartitionedConvolver::partitionSize;
+    auto length = PartitionedConvolver::getKernelLength (sampleRate);
+
+    // zero phase spectrum with the cascade's magnitude, delayed by length / 2,
+    // i.e. each bin k rotated by e^(-j pi k) = (-1)^k
+    juce::dsp::FFT firFFT (getOrder (length));
+    std::vector<float> fir ((size_t) length * 2, 0.f);
+
+    for (int k = 0; k <= length / 2; ++k)
+    {
+        auto frequency = sampleRate * k / length;
+        auto magnitude = 1.0;
+
+        for (int i = 0; i < setup.numActive; ++i)
+            magnitude *= FilterDesign::getMagnitude (setup.sections[(size_t) setup.activeSections[(size_t) i]], frequency, sampleRate);
+
+        fir[(size_t) k * 2] = (float) ((k & 1) != 0 ? -magnitude : magnitude);
+    }
+
+    firFFT.performRealOnlyInverseTransform (fir.data());
+
+    for (int n = 0; n < length; ++n)
+    {
+        auto phase = juce::MathConstants<double>::twoPi * n / length;
+        fir[(size_t) n] *= (float) (0.42 - 0.5 * std::cos (phase) + 0.08 * std::cos (2.0 * phase));
+    }
+
+    kernel.partitionSize = partitionSize;
+    kernel.numPartitions = length / partitionSize;
+    kernel.spectra.resize ((size_t) (kernel.numPartitions * (partitionSize + 1)));
+
+    juce::dsp::FFT partitionFFT (getOrder (partitionSize * 2));
+    std::vector<float> buffer ((size_t) partitionSize * 4);
+
+    for (int p = 0; p < kernel.numPartitions; ++p)
+    {
+        std::fill (buffer.begin(), buffer.end(), 0.f);
+        std::copy (fir.begin() + p * partitionSize, fir.begin() + (p + 1) * partitionSize, buffer.begin());
+        partitionFFT.performRealOnlyForwardTransform (buffer.data(), true);
+
+        auto* spectrum = reinterpret_cast<const std::complex<float>*> (buffer.data());
+        std::copy (spectrum, spectrum + partitionSize + 1, kernel.spectra.begin() + p * (partitionSize + 1));
+    }
+}
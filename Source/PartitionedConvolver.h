@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCascade.h"
+
+//==============================================================================
+/** Frequency domain partitions of an FIR, ready for PartitionedConvolver. */
+struct ConvolutionKernel
+{
+    int partitionSize = 0;
+    int numPartitions = 0;
+
+    /** numPartitions blocks of partitionSize + 1 bins. */
+    std::vector<std::complex<float>> spectra;
+};
+
+//==============================================================================
+/**
+    Uniformly partitioned overlap-save convolution built on juce::dsp::FFT.
+
+    Every partitionSize samples each channel's input frame is transformed once
+    into a frequency domain delay line, multiplied with all kernel partitions
+    and transformed back. The latency added on top of the kernel's own delay is
+    one partition.
+
+    New kernels are designed elsewhere (see makeLinearPhaseKernel) and handed
+    over with setKernel(), which only takes a reference to the shared kernel,
+    so every instance convolves with the same spectra; the switch is
+    crossfaded over the next partition so it never clicks.
+*/
+class PartitionedConvolver
+{
+public:
+    PartitionedConvolver() = default;
+
+    static constexpr int partitionSize = 512;
+
+    /** FIR length used for linear phase at a given rate: ~170 ms, rounded up to a power of two. */
+    static int getKernelLength (double sampleRate) noexcept;
+
+    /** Delay through the convolver for a symmetric kernel of getKernelLength() taps. */
+    static int getLatencySamples (double sampleRate) noexcept;
+
+    void prepare (const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    /** Audio thread: references the kernel and starts a crossfade. Kernels whose size
+        doesn't match what prepare() set up for are ignored. Nothing is copied or freed
+        here, so the caller's side has to hold on to every kernel it hands over until
+        the convolver has let go of it (see CoefficientDesigner::getKernels). */
+    void setKernel (const std::shared_ptr<const ConvolutionKernel>& kernel) noexcept;
+
+    void process (const juce::dsp::ProcessContextReplacing<float>& context) noexcept;
+
+private:
+    void processFrame() noexcept;
+
+    int numPartitions = 0, numBins = 0;
+    size_t numChannels = 0;
+    int framePosition = 0, delayLineIndex = 0;
+    bool fadePending = false;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::shared_ptr<const ConvolutionKernel> passthrough, currentKernel, nextKernel;
+    std::vector<std::complex<float>> delayLine;       // channels * partitions * bins
+    juce::AudioBuffer<float> inputFrames;              // 2 * partitionSize per channel
+    juce::AudioBuffer<float> outputFrames;             // partitionSize per channel
+    std::vector<float> fftBuffer, fadeBuffer;
+    std::vector<std::complex<float>> accumulator;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PartitionedConvolver)
+};
+
+//==============================================================================
+/** Builds a zero phase FIR with the magnitude response of the given cascade,
+    delayed to the middle of its length and windowed, and partitions it for
+    PartitionedConvolver. Allocates - call it from a background thread. */
+void makeLinearPhaseKernel (const CascadeSetup& setup, double sampleRate, ConvolutionKernel& kernel);
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.cpp
+
+  ==============================================================================
+*/
+
+#include "PerformanceMonitor.h"
+
+//==============================================================================
+namespace
+{
+    // per thread, so instances on different audio threads never see each other's calls
+    thread_local bool inBlock = false;
+    thread_local juce::uint64 blockAllocations = 0;
+}
+
+void PerformanceMonitor::countHeapCall() noexcept
+{
+    if (inBlock)
+        ++blockAllocations;
+}
+
+//==============================================================================
+double PerformanceMonitor::Snapshot::getPercentile (double fraction) const noexcept
+{
+    juce::uint64 total = 0;
+    for (auto count : histogram)
+        total += count;
+
+    if (total == 0)
+        return 0.0;
+
+    auto target = (juce::uint64) std::ceil (juce::jlimit (0.0, 1.0, fraction) * (double) total);
+    juce::uint64 sum = 0;
+
+    for (int i = 0; i < numBins; ++i)
+    {
+        sum += histogram[(size_t) i];
+
+        // upper edge of the bin, which can't be worse than the worst block
+        if (sum >= target && sum > 0)
+            return i < numBins - 1 ? juce::jmin ((i + 1) * binWidth, peakLoad) : peakLoad;
+    }
+
+    return peakLoad;
+}
+
+juce::String PerformanceMonitor::Snapshot::toString() const
+{
+    auto percent = [] (double load) { return juce::String (load * 100.0, 1) + "%"; };
+
+    return "CPU " + percent (load)
+         + "  p50 " + percent (getPercentile (0.5))
+         + "  p99 " + percent (getPercentile (0.99))
+         + "  peak " + percent (peakLoad)
+         + "  misses " + juce::String (numMisses) + "/" + juce::String (numBlocks)
+         + "  redesigns " + juce::String (numRedesigns) + " (" + juce::String (redesignsPerSecond, 1) + "/s)"
+        #if PHASEEQ_COUNT_ALLOCATIONS
+         + "  heap calls " + juce::String (numAllocations)
+        #endif
+         ;
+}
+
+//==============================================================================
+void PerformanceMonitor::prepare (double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+    resetPending = false;
+    clear();
+}
+
+void PerformanceMonitor::clear() noexcept
+{
+    totals = Snapshot();
+    totals.sampleRate = sampleRate;
+    windowTicks = windowSamples = 0;
+    windowRedesigns = 0;
+    windowPeak = 0.0;
+}
+
+PerformanceMonitor::ScopedBlock::ScopedBlock (PerformanceMonitor& m, int numSamplesToProcess) noexcept
+    : monitor (m), numSamples (numSamplesToProcess), startAllocations (blockAllocations), wasInBlock (inBlock)
+{
+    if (monitor.resetPending.exchange (false))
+        monitor.clear();
+
+    inBlock = true;
+    startTicks = juce::Time::getHighResolutionTicks();
+}
+
+PerformanceMonitor::ScopedBlock::~ScopedBlock() noexcept
+{
+    auto elapsed = juce::Time::getHighResolutionTicks() - startTicks;
+    inBlock = wasInBlock;
+    monitor.endBlock (elapsed, numSamples, blockAllocations - startAllocations);
+}
+
+void PerformanceMonitor::endBlock (juce::int64 elapsedTicks, int numSamples, juce::uint64 allocations) noexcept
+{
+    if (sampleRate <= 0.0 || numSamples <= 0)
+        return;
+
+    auto load = (double) elapsedTicks / ticksPerSecond * sampleRate / numSamples;
+    auto bin = juce::jlimit (0, numBins - 1, (int) (load / binWidth));
+
+    ++totals.histogram[(size_t) bin];
+    ++totals.numBlocks;
+    totals.numMisses += load > 1.0 ? 1 : 0;
+    totals.numAllocations += allocations;
+    totals.peakLoad = juce::jmax (totals.peakLoad, load);
+
+    windowTicks += elapsedTicks;
+    windowSamples += numSamples;
+    windowPeak = juce::jmax (windowPeak, load);
+
+    if ((double) windowSamples >= sampleRate * publishInterval)
+        publish();
+}
+
+void PerformanceMonitor::publish() noexcept
+{
+    if (windowSamples > 0)
+    {
+        auto seconds = (double) windowSamples / sampleRate;
+        totals.load = (double) windowTicks / ticksPerSecond / seconds;
+        totals.recentPeakLoad = windowPeak;
+        totals.redesignsPerSecond = (double) windowRedesigns / seconds;
+    }
+
+    snapshots.push (totals);
+
+    windowTicks = windowSamples = 0;
+    windowRedesigns = 0;
+    windowPeak = 0.0;
+}
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+/** Reports the heap calls made while a block is being processed. Only the tools
+    define it, as they link Tools/Common/AllocationCounter.cpp, which replaces the
+    global operator new and delete of the executable; the plugin never does. */
+#ifndef PHASEEQ_COUNT_ALLOCATIONS
+ #define PHASEEQ_COUNT_ALLOCATIONS 0
+#endif
+
+//==============================================================================
+/**
+    What processBlock costs, measured on the audio thread and read anywhere else.
+
+    Each block is timed against its real-time budget - its length in seconds -
+    and the ratio, its load, goes into a histogram. A block with a load above 1
+    missed its deadline on its own; in a host it shares that budget with
+    everything else, so misses are what PhaseEQ alone made inevitable.
+
+    The audio thread only touches plain members and, a few times a second,
+    copies them into a TripleBuffer; it never waits and never allocates. The
+    message thread, or a tool after rendering, picks up the latest Snapshot.
+*/
+class PerformanceMonitor
+{
+public:
+    PerformanceMonitor() = default;
+
+    static constexpr int numBins = 50;
+    static constexpr double binWidth = 0.05;    // of the budget; the last bin takes everything above
+
+    struct Snapshot
+    {
+        double sampleRate = 0.0;
+        juce::uint64 numBlocks = 0, numMisses = 0, numRedesigns = 0;
+        juce::uint64 numAllocations = 0;        // heap calls inside blocks, if PHASEEQ_COUNT_ALLOCATIONS
+
+        double load = 0.0;                      // time spent over time processed, since the last snapshot
+        double recentPeakLoad = 0.0;            // worst block since the last snapshot
+        double peakLoad = 0.0;                  // worst block since reset
+        double redesignsPerSecond = 0.0;        // of audio, since the last snapshot
+
+        std::array<juce::uint32, numBins> histogram {};
+
+        /** Load that this fraction of blocks stayed under, to the resolution of the histogram. */
+        double getPercentile (double fraction) const noexcept;
+
+        /** One line summary, for the editor overlay and the tools. */
+        juce::String toString() const;
+    };
+
+    //==============================================================================
+    /** Starts over at a new rate. Call it while the audio thread isn't running. */
+    void prepare (double newSampleRate) noexcept;
+
+    /** Audio thread: times one block from construction to destruction. */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (PerformanceMonitor& m, int numSamplesToProcess) noexcept;
+        ~ScopedBlock() noexcept;
+
+    private:
+        PerformanceMonitor& monitor;
+        int numSamples;
+        juce::int64 startTicks;
+        juce::uint64 startAllocations;
+        bool wasInBlock;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    /** Any thread: counts a heap call against the block the thread is in, if any.
+        Called by the replacement operator new and delete the tools link in. */
+    static void countHeapCall() noexcept;
+
+    /** Audio thread: a new set of coefficients or a new kernel was taken on. */
+    void countRedesign() noexcept                           { ++totals.numRedesigns; ++windowRedesigns; }
+
+    /** Audio thread: hands the counters over now rather than at the next interval,
+        e.g. at the end of an offline render. */
+    void publish() noexcept;
+
+    //==============================================================================
+    /** Any other single thread: returns true if a newer snapshot arrived. */
+    bool update() noexcept                                  { return snapshots.update(); }
+    const Snapshot& getSnapshot() const noexcept            { return snapshots.getReadBuffer(); }
+
+    /** Any thread: clears the totals and the histogram before the next block. */
+    void reset() noexcept                                   { resetPending = true; }
+
+private:
+    void endBlock (juce::int64 elapsedTicks, int numSamples, juce::uint64 allocations) noexcept;
+    void clear() noexcept;
+
+    static constexpr double publishInterval = 0.25;         // seconds of audio
+
+    double sampleRate = 0.0, ticksPerSecond = 1.0;
+    Snapshot totals;
+    juce::int64 windowTicks = 0, windowSamples = 0;
+    juce::uint64 windowRedesigns = 0;
+    double windowPeak = 0.0;
+
+    std::atomic<bool> resetPending { false };
+    TripleBuffer<Snapshot> snapshots;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PerformanceMonitor)
+};
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    PhaseCorrection.cpp
+
+  ==============================================================================
+*/
+
+#include "PhaseCorrection.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int numPoints = 64;
+    constexpr int numCandidateFrequencies = 32;
+    constexpr int numCandidateQs = 12;
+    constexpr double minQ = 0.3, maxQ = 8.0;
+
+    /** Fraction of the remaining variance a section has to remove to be worth running. */
+    constexpr double minImprovement = 0.03;
+
+    double logInterpolate (double low, double high, int index, int count) noexcept
+    {
+        return low * std::pow (high / low, count > 1 ? (double) index / (count - 1) : 0.0);
+    }
+
+    double getVariance (const double* delay, const double* extra) noexcept
+    {
+        auto sum = 0.0, sumOfSquares = 0.0;
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            auto d = delay[i] + (extra != nullptr ? extra[i] : 0.0);
+            sum += d;
+            sumOfSquares += d * d;
+        }
+
+        auto mean = sum / numPoints;
+        return juce::jmax (0.0, sumOfSquares / numPoints - mean * mean);
+    }
+}
+
+//==============================================================================
+void makePhaseCorrection (const CascadeSetup& setup, double lowFrequency, double highFrequency, PhaseCorrection& correction)
+{
+    correction.numSections = 0;
+    correction.delaySamples = 0.0;
+
+    auto rate = setup.sampleRate;
+    if (rate <= 0.0 || setup.numActive == 0)
+        return;
+
+    lowFrequency = juce::jlimit (1.0, rate * 0.45, lowFrequency);
+    highFrequency = juce::jlimit (lowFrequency, rate * 0.45, highFrequency);
+
+    if (highFrequency < lowFrequency * 1.05)
+        return;
+
+    std::array<double, numPoints> frequencies, delay {};
+
+    for (int i = 0; i < numPoints; ++i)
+    {
+        frequencies[(size_t) i] = logInterpolate (lowFrequency, highFrequency, i, numPoints);
+
+        for (int s = 0; s < setup.numActive; ++s)
+            delay[(size_t) i] += FilterDesign::getGroupDelay (setup.sections[(size_t) setup.activeSections[(size_t) s]],
+                                                            frequencies[(size_t) i], rate);
+    }
+
+    // every candidate's delay curve, worked out once; picking sections then only takes additions
+    constexpr int numCandidates = numCandidateFrequencies * numCandidateQs;
+    std::vector<BiquadCoefficients> candidates ((size_t) numCandidates);
+    std::vector<double> curves ((size_t) (numCandidates * numPoints));
+
+    for (int f = 0; f < numCandidateFrequencies; ++f)
+    {
+        for (int q = 0; q < numCandidateQs; ++q)
+        {
+            auto index = f * numCandidateQs + q;
+            auto& c = candidates[(size_t) index];
+            c = FilterDesign::design (FilterDesign::allPass, rate,
+                                      logInterpolate (lowFrequency, highFrequency, f, numCandidateFrequencies),
+                                      logInterpolate (minQ, maxQ, q, numCandidateQs), 0.0);
+
+            for (int i = 0; i < numPoints; ++i)
+                curves[(size_t) (index * numPoints + i)] = FilterDesign::getGroupDelay (c, frequencies[(size_t) i], rate);
+        }
+    }
+
+    auto getCurve = [&] (int index) { return curves.data() + index * numPoints; };
+
+    auto findBest = [&] (double& bestVariance)
+    {
+        auto best = -1;
+
+        for (int c = 0; c < numCandidates; ++c)
+        {
+            auto variance = getVariance (delay.data(), getCurve (c));
+
+            if (variance < bestVariance)
+            {
+                bestVariance = variance;
+                best = c;
+            }
+        }
+
+        return best;
+    };
+
+    auto addCurve = [&] (int index, double sign)
+    {
+        auto* curve = getCurve (index);
+        for (int i = 0; i < numPoints; ++i)
+            delay[(size_t) i] += sign * curve[i];
+    };
+
+    std::array<int, PhaseCorrection::maxSections> picks;
+    auto variance = getVariance (delay.data(), nullptr);
+
+    // a delay that's already flat to well under a sample needs nothing
+    while (correction.numSections < PhaseCorrection::maxSections && variance > 0.01)
+    {
+        auto bestVariance = variance * (1.0 - minImprovement);
+        auto best = findBest (bestVariance);
+
+        if (best < 0)
+            break;
+
+        addCurve (best, 1.0);
+        picks[(size_t) correction.numSections++] = best;
+        variance = bestVariance;
+    }
+
+    // greedy picks are made without knowing what comes after them; revisit each with the rest in place
+    for (int s = 0; s < correction.numSections; ++s)
+    {
+        addCurve (picks[(size_t) s], -1.0);
+
+        auto bestVariance = std::numeric_limits<double>::max();
+        picks[(size_t) s] = findBest (bestVariance);
+        addCurve (picks[(size_t) s], 1.0);
+    }
+
+    auto sum = 0.0;
+    for (auto d : delay)
+        sum += d;
+
+    correction.delaySamples = sum / numPoints;
+
+    for (int s = 0; s < correction.numSections; ++s)
+        correction.sections[(size_t) s] = candidates[(size_t) picks[(size_t) s]];
+}
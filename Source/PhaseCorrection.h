@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    PhaseCorrection.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCascade.h"
+
+//==============================================================================
+/**
+    All-pass sections that, run after the EQ, flatten its group delay over a
+    chosen frequency range, so the EQ behaves like a fixed delay there while
+    costing no more than a few extra biquads.
+
+    The magnitude response is untouched: only sections with b = reversed a are
+    ever added.
+*/
+struct PhaseCorrection
+{
+    static constexpr int maxSections = 8;
+
+    std::array<BiquadCoefficients, maxSections> sections;
+    int numSections = 0;
+
+    /** Mean group delay of the EQ plus the correction across the range, in samples at
+        the setup's rate - the fixed delay the corrected curve settles around. */
+    double delaySamples = 0.0;
+};
+
+//==============================================================================
+/** Fits a PhaseCorrection to the active sections of the setup between lowFrequency
+    and highFrequency.
+
+    The sections are picked greedily from a grid of all-pass centres and Qs,
+    each one the candidate that takes the most off the variance of the total
+    group delay over a log spaced set of frequencies, followed by a pass that
+    revisits every pick with the others in place. It stops early once another
+    section would help by less than a few percent.
+
+    Every section of the setup counts, whichever channels it runs on, and
+    dynamic bands are taken at their static gain. Allocates - call it from a
+    background thread.
+*/
+void makePhaseCorrection (const CascadeSetup& setup, double lowFrequency, double highFrequency, PhaseCorrection& correction);
@@ -1,173 +1,574 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-PhaseEQAudioProcessorEditor::PhaseEQAudioProcessorEditor (PhaseEQAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
-{
-    setSize (1000, 800);
-    startTimerHz(60);
-
-    int padding = 50;
-    window.setSize(getWidth()-padding, getHeight()*1/2);
-    window.setLeft(padding*3);
-    window.setTop(padding);
-
-    freqs.resize(window.getWidth());
-    for(int i = 0; i < freqs.size(); i++)
-    {
-        freqs.set(i, audioProcessor.getSampleRate()/2.f * (1.0f - std::exp (std::log (1.0f - (float) i / (float) freqs.size()) * 0.1f)));
-    }
-    mags.resize(window.getWidth());
-    mags.fill(0);
-    phases.resize(window.getWidth());
-    phases.fill(0);
-
-    /* initialize parameters */
-
-    freqKnob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
-    freqKnob.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
-    freqKnob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 20);
-    freqKnob.setTextValueSuffix(" Hz");
-    freqKnob.onValueChange = [this] {audioProcessor.setUpdate(true);};
-    freqAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(),"FREQ",freqKnob);
-    freqLabel.setText("Frequency", juce::dontSendNotification);
-    freqLabel.setJustificationType(juce::Justification::horizontallyCentred);
-    freqLabel.attachToComponent(&freqKnob, true);
-    addAndMakeVisible(freqKnob);
-
-    gainKnob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
-    gainKnob.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
-    gainKnob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 20);
-    gainKnob.setTextValueSuffix(" dB");
-    gainKnob.onValueChange = [this] {audioProcessor.setUpdate(true);};
-    gainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(),"GAIN",gainKnob);
-    gainLabel.setText("Gain", juce::dontSendNotification);
-    gainLabel.setJustificationType(juce::Justification::horizontallyCentred);
-    gainLabel.attachToComponent(&gainKnob, true);
-    addAndMakeVisible(gainKnob);
-
-    qKnob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
-    qKnob.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
-    qKnob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 20);
-    qKnob.onValueChange = [this] {audioProcessor.setUpdate(true);};
-    qAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(),"Q",qKnob);
-    qLabel.setText("Q", juce::dontSendNotification);
-    qLabel.setJustificationType(juce::Justification::horizontallyCentred);
-    qLabel.attachToComponent(&qKnob, true);
-    addAndMakeVisible(qKnob);
-
-    filtersList.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
-    filtersList.onChange = [this] {audioProcessor.setUpdate(true);};
-    auto items = audioProcessor.getFiltersList();
-    for(int i = 0; i < items.size(); i++)
-        filtersList.addItem(items[i], i+1);
-    filtersAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(),"FILTERS",filtersList);
-    filtersLabel.setText("Filters", juce::dontSendNotification);
-    filtersLabel.setJustificationType(juce::Justification::horizontallyCentred);
-    filtersLabel.attachToComponent(&filtersList, true);
-    addAndMakeVisible(filtersList);
-
-
-    /* set positions */
-    int spacing = 60;
-    int gap = spacing*3/4;
-
-//    freqKnob.setBounds(window);
-    freqKnob.setBounds(getWidth()/3, getHeight()-spacing*4-gap, 400, 50);
-    gainKnob.setBounds(getWidth()/3, getHeight()-spacing*3-gap, 400, 50);
-    qKnob.setBounds(getWidth()/3, getHeight()-spacing*2-gap, 400, 50);
-    filtersList.setBounds(100, getHeight()-spacing*4-gap, 100, 25);
-}
-
-PhaseEQAudioProcessorEditor::~PhaseEQAudioProcessorEditor()
-{
-}
-
-//==============================================================================
-void PhaseEQAudioProcessorEditor::paint (juce::Graphics& g)
-{
-    g.fillAll (juce::Colours::black);
-    g.setColour(juce::Colours::lightgrey);
-
-    plot(g);
-}
-
-void PhaseEQAudioProcessorEditor::plot(juce::Graphics& g)
-{
-    audioProcessor.getFreqResponse(freqs.getRawDataPointer(), mags.getRawDataPointer(), freqs.size());
-    audioProcessor.getPhaseResponse(freqs.getRawDataPointer(), phases.getRawDataPointer(), freqs.size());
-
-    int w  = window.getWidth() - 1;  // window width
-    int h  = window.getHeight() - 1; // window height
-    int l  = window.getX();          // window left
-    int r  = l + w;                  // window right
-    int b  = window.getY();          // window bottom
-    int t  = b + h;                  // window top
-    float yMax = 10.f;
-    float yMin = -10.f;
-
-    {
-        g.setColour(juce::Colours::lightgreen);
-        auto valToCoord = [&](float v)
-        {
-            return juce::jlimit(b, t, b + int(juce::jmap(juce::Decibels::gainToDecibels(v), yMax, yMin, 0.f, float(h))));
-        };
-
-        for (int i = 1; i < w; i++)
-        {
-            int x1 = i + l;
-            int y1 = valToCoord(mags[i]);
-            int y2 = valToCoord(mags[i + 1]);
-
-            if(y1 < y2)
-            {
-                std::swap(y1, y2);
-            }
-            g.fillRect(x1, y2, 1, 1 + (y1 - y2));
-        }
-    }
-    {
-        g.setColour(juce::Colours::dodgerblue);
-        auto valToCoord = [&](float v)
-        {
-            return juce::jlimit(b, t, b + int(juce::jmap(juce::radiansToDegrees(v), -180.f, 180.f, 0.f, float(h))));
-        };
-
-        for (int i = 1; i < w; i++)
-        {
-            int x1 = i + l;
-            int y1 = valToCoord(phases[i]);
-            int y2 = valToCoord(phases[i + 1]);
-
-            if(y1 < y2)
-            {
-                std::swap(y1, y2);
-            }
-            g.fillRect(x1, y2, 1, 1 + (y1 - y2));
-        }
-    }
-    g.setColour(juce::Colours::lightgrey);
-    g.drawRect(window);
-}
-
-void PhaseEQAudioProcessorEditor::resized()
-{
-}
-
-void PhaseEQAudioProcessorEditor::timerCallback()
-{
-    if(audioProcessor.checkForUpdates())
-    {
-        repaint();
-        audioProcessor.setUpdateGUI(false);
-    }
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+//==============================================================================
+PhaseEQAudioProcessorEditor::PhaseEQAudioProcessorEditor (PhaseEQAudioProcessor& p)
+    : AudioProcessorEditor (&p), audioProcessor (p)
+{
+    setSize (1000, 900);
+    startTimerHz(60);
+
+    int padding = 50;
+    window.setSize(getWidth()-padding, getHeight()*1/2);
+    window.setLeft(padding*3);
+    window.setTop(padding);
+
+    freqs.resize(window.getWidth());
+
+    /* initialize parameters */
+
+    freqKnob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
+    freqKnob.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    freqKnob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 20);
+    freqKnob.setTextValueSuffix(" Hz");
+    freqKnob.onValueChange = [this] {audioProcessor.setUpdate(true);};
+    freqLabel.setText("Frequency", juce::dontSendNotification);
+    freqLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    freqLabel.attachToComponent(&freqKnob, true);
+    addAndMakeVisible(freqKnob);
+
+    gainKnob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
+    gainKnob.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    gainKnob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 20);
+    gainKnob.setTextValueSuffix(" dB");
+    gainKnob.onValueChange = [this] {audioProcessor.setUpdate(true);};
+    gainLabel.setText("Gain", juce::dontSendNotification);
+    gainLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    gainLabel.attachToComponent(&gainKnob, true);
+    addAndMakeVisible(gainKnob);
+
+    qKnob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
+    qKnob.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    qKnob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 20);
+    qKnob.onValueChange = [this] {audioProcessor.setUpdate(true);};
+    qLabel.setText("Q", juce::dontSendNotification);
+    qLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    qLabel.attachToComponent(&qKnob, true);
+    addAndMakeVisible(qKnob);
+
+    filtersList.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
+    filtersList.onChange = [this] {audioProcessor.setUpdate(true); updateSlopeControls();};
+    auto items = audioProcessor.getFiltersList();
+    for(int i = 0; i < items.size(); i++)
+        filtersList.addItem(items[i], i+1);
+    filtersLabel.setText("Filters", juce::dontSendNotification);
+    filtersLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    filtersLabel.attachToComponent(&filtersList, true);
+    addAndMakeVisible(filtersList);
+
+    // only Low Pass and High Pass have a slope; the lists sit next to the type and band
+    slopeList.addItemList(audioProcessor.getSlopesList(), 1);
+    addAndMakeVisible(slopeList);
+    characteristicList.addItemList(audioProcessor.getCharacteristicsList(), 1);
+    addAndMakeVisible(characteristicList);
+
+    channelsList.addItemList(audioProcessor.getChannelsList(), 1);
+    channelsLabel.setText("Channels", juce::dontSendNotification);
+    channelsLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    channelsLabel.attachToComponent(&channelsList, true);
+    addAndMakeVisible(channelsList);
+
+    routingList.addItemList(audioProcessor.getRoutingList(), 1);
+    routingLabel.setText("Routing", juce::dontSendNotification);
+    routingLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    routingLabel.attachToComponent(&routingList, true);
+    addAndMakeVisible(routingList);
+
+    auto setUpRotaryKnob = [this](juce::Slider& knob, juce::Label& label, const juce::String& name, const juce::String& suffix)
+    {
+        knob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
+        knob.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+        knob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 80, 20);
+        knob.setTextValueSuffix(suffix);
+        knob.onValueChange = [this] {audioProcessor.setUpdate(true);};
+        label.setText(name, juce::dontSendNotification);
+        label.setJustificationType(juce::Justification::horizontallyCentred);
+        label.attachToComponent(&knob, false);
+        addAndMakeVisible(knob);
+    };
+    setUpRotaryKnob(thresholdKnob, thresholdLabel, "Threshold", " dB");
+    setUpRotaryKnob(ratioKnob, ratioLabel, "Ratio", ":1");
+    setUpRotaryKnob(attackKnob, attackLabel, "Attack", " ms");
+    setUpRotaryKnob(releaseKnob, releaseLabel, "Release", " ms");
+    setUpRotaryKnob(correctionLowKnob, correctionLowLabel, "Correct From", " Hz");
+    setUpRotaryKnob(correctionHighKnob, correctionHighLabel, "Correct To", " Hz");
+    correctionLowAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(),ParameterIDs::correctionLow,correctionLowKnob);
+    correctionHighAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(),ParameterIDs::correctionHigh,correctionHighKnob);
+    addAndMakeVisible(dynamicButton);
+    addAndMakeVisible(sidechainButton);
+
+    // arms the shown band's parameter; the next controller to arrive takes it over
+    learnList.addItemList({"Off", "Freq", "Gain", "Q"}, 1);
+    learnList.setSelectedItemIndex(0, juce::dontSendNotification);
+    learnList.onChange = [this]
+    {
+        auto target = learnList.getSelectedItemIndex() - 1;
+        audioProcessor.getMidiControl().learn(target < 0 ? -1 : MidiControl::getMapping(bandList.getSelectedItemIndex(), target));
+    };
+    learnLabel.setText("MIDI Learn", juce::dontSendNotification);
+    learnLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    learnLabel.attachToComponent(&learnList, true);
+    addAndMakeVisible(learnList);
+    forgetButton.onClick = [this]
+    {
+        for(int target = 0; target < MidiControl::numTargets; target++)
+            audioProcessor.getMidiControl().forget(MidiControl::getMapping(bandList.getSelectedItemIndex(), target));
+        updateMidiLabel();
+    };
+    addAndMakeVisible(forgetButton);
+    addAndMakeVisible(midiLabel);
+
+    for(int i = 0; i < ParameterIDs::numBands; i++)
+        bandList.addItem("Band " + juce::String(i + 1), i+1);
+    bandList.onChange = [this] {attachToBand(bandList.getSelectedItemIndex());};
+    bandLabel.setText("Band", juce::dontSendNotification);
+    bandLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    bandLabel.attachToComponent(&bandList, true);
+    addAndMakeVisible(bandList);
+    addAndMakeVisible(enabledButton);
+    bandList.setSelectedItemIndex(0, juce::dontSendNotification);
+    attachToBand(0);
+
+    smoothingKnob.setColour(juce::Slider::ColourIds::thumbColourId, juce::Colours::lightgrey);
+    smoothingKnob.setSliderStyle(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag);
+    smoothingKnob.setTextBoxStyle(juce::Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 20);
+    smoothingKnob.setTextValueSuffix(" ms");
+    smoothingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(),ParameterIDs::smoothing,smoothingKnob);
+    smoothingLabel.setText("Smoothing", juce::dontSendNotification);
+    smoothingLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    smoothingLabel.attachToComponent(&smoothingKnob, false);
+    addAndMakeVisible(smoothingKnob);
+
+    phaseModeList.addItemList({"Minimum", "Linear", "Corrected"}, 1);
+    phaseModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(),ParameterIDs::phaseMode,phaseModeList);
+    phaseModeLabel.setText("Phase", juce::dontSendNotification);
+    phaseModeLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    phaseModeLabel.attachToComponent(&phaseModeList, true);
+    addAndMakeVisible(phaseModeList);
+
+    oversamplingList.addItemList({"Off", "2x", "4x", "8x"}, 1);
+    oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(),ParameterIDs::oversampling,oversamplingList);
+    oversamplingLabel.setText("Oversampling", juce::dontSendNotification);
+    oversamplingLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    oversamplingLabel.attachToComponent(&oversamplingList, true);
+    addAndMakeVisible(oversamplingList);
+
+    // processor load overlay, counted from when it's switched on
+    statsButton.onClick = [this]
+    {
+        if(statsButton.getToggleState())
+            audioProcessor.getPerformanceMonitor().reset();
+
+        statsText.clear();
+        repaint(window);
+    };
+    addAndMakeVisible(statsButton);
+
+    // keeps the output as loud as the input, so boosts don't win comparisons by level alone
+    autoGainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.getParameters(),ParameterIDs::autoGain,autoGainButton);
+    autoGainButton.onClick = [this] {updateLoudness();};
+    addAndMakeVisible(autoGainButton);
+    addAndMakeVisible(loudnessLabel);
+
+    // fits the bands to make one file sound like another, see MatchEQ
+    matchButton.onClick = [this] {chooseMatchFiles();};
+    addAndMakeVisible(matchButton);
+    addAndMakeVisible(matchLabel);
+
+    oversamplingQualityList.addItemList({"Efficient", "Linear Phase"}, 1);
+    oversamplingQualityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(),ParameterIDs::oversamplingQuality,oversamplingQualityList);
+    oversamplingQualityLabel.setText("Quality", juce::dontSendNotification);
+    oversamplingQualityLabel.setJustificationType(juce::Justification::horizontallyCentred);
+    oversamplingQualityLabel.attachToComponent(&oversamplingQualityList, true);
+    addAndMakeVisible(oversamplingQualityList);
+
+    /* set positions */
+    int spacing = 60;
+    int gap = spacing*3/4;
+
+//    freqKnob.setBounds(window);
+    freqKnob.setBounds(getWidth()/3, getHeight()-spacing*4-gap, 400, 50);
+    gainKnob.setBounds(getWidth()/3, getHeight()-spacing*3-gap, 400, 50);
+    qKnob.setBounds(getWidth()/3, getHeight()-spacing*2-gap, 400, 50);
+    filtersList.setBounds(100, getHeight()-spacing*4-gap, 100, 25);
+    bandList.setBounds(100, getHeight()-spacing*3-gap, 100, 25);
+    slopeList.setBounds(210, getHeight()-spacing*4-gap, 110, 25);
+    characteristicList.setBounds(210, getHeight()-spacing*3-gap, 110, 25);
+    enabledButton.setBounds(100, getHeight()-spacing*2-gap, 100, 25);
+    channelsList.setBounds(100, getHeight()-spacing-gap, 100, 25);
+    routingList.setBounds(getWidth()/3+100, getHeight()-spacing-gap, 100, 25);
+    learnList.setBounds(getWidth()/3+270, getHeight()-spacing-gap, 100, 25);
+    forgetButton.setBounds(getWidth()/3+380, getHeight()-spacing-gap, 80, 25);
+    midiLabel.setBounds(getWidth()/3+200, getHeight()-gap+5, 300, 20);
+    dynamicButton.setBounds(100, getHeight()-spacing*5-gap+10, 100, 25);
+    sidechainButton.setBounds(100, getHeight()-spacing*5-gap+35, 100, 25);
+    thresholdKnob.setBounds(getWidth()/3, getHeight()-spacing*6-gap+25, 90, 85);
+    ratioKnob.setBounds(getWidth()/3+100, getHeight()-spacing*6-gap+25, 90, 85);
+    attackKnob.setBounds(getWidth()/3+200, getHeight()-spacing*6-gap+25, 90, 85);
+    releaseKnob.setBounds(getWidth()/3+300, getHeight()-spacing*6-gap+25, 90, 85);
+    correctionLowKnob.setBounds(getWidth()-230, getHeight()-spacing*6-gap+25, 90, 85);
+    correctionHighKnob.setBounds(getWidth()-130, getHeight()-spacing*6-gap+25, 90, 85);
+    smoothingKnob.setBounds(getWidth()-180, getHeight()-spacing*4-gap+20, 100, 100);
+    phaseModeList.setBounds(getWidth()-180, getHeight()-spacing*2-gap+20, 100, 25);
+    oversamplingList.setBounds(getWidth()-180, getHeight()-spacing*2-gap+50, 100, 25);
+    oversamplingQualityList.setBounds(getWidth()-180, getHeight()-spacing*2-gap+80, 100, 25);
+    statsButton.setBounds(padding*3, 15, 80, 25);
+    autoGainButton.setBounds(padding*3+90, 15, 100, 25);
+    loudnessLabel.setBounds(padding*3+190, 17, 400, 20);
+    matchButton.setBounds(15, 15, 110, 25);
+    matchLabel.setBounds(15, 45, 120, 40);
+
+    updateResponse();
+
+    // the analysers only collect audio while someone is looking
+    audioProcessor.getPreAnalyser().setActive(true);
+    audioProcessor.getPostAnalyser().setActive(true);
+}
+
+PhaseEQAudioProcessorEditor::~PhaseEQAudioProcessorEditor()
+{
+    audioProcessor.getPreAnalyser().setActive(false);
+    audioProcessor.getPostAnalyser().setActive(false);
+}
+
+//==============================================================================
+void PhaseEQAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colours::black);
+    g.setColour(juce::Colours::lightgrey);
+
+    plot(g);
+}
+
+void PhaseEQAudioProcessorEditor::plot(juce::Graphics& g)
+{
+    g.setColour(juce::Colours::grey.withAlpha(0.5f));
+    g.strokePath(preSpectrumPath, juce::PathStrokeType(1.f));
+    g.setColour(juce::Colours::white.withAlpha(0.6f));
+    g.strokePath(postSpectrumPath, juce::PathStrokeType(1.f));
+    g.setColour(juce::Colours::orange.withAlpha(0.6f));
+    g.strokePath(peakPath, juce::PathStrokeType(1.f));
+
+    g.setColour(juce::Colours::lightgreen);
+    g.strokePath(magnitudePath, juce::PathStrokeType(1.f));
+    g.setColour(juce::Colours::dodgerblue);
+    g.strokePath(phasePath, juce::PathStrokeType(1.f));
+    g.setColour(juce::Colours::yellow.withAlpha(0.8f));
+    g.strokePath(groupDelayPath, juce::PathStrokeType(1.f));
+
+    g.setColour(juce::Colours::lightgrey);
+    g.drawRect(window);
+
+    if(statsText.isNotEmpty())
+        g.drawText(statsText, window.reduced(8).removeFromTop(20), juce::Justification::topLeft);
+}
+
+void PhaseEQAudioProcessorEditor::updateResponse()
+{
+    auto sampleRate = audioProcessor.getDesignSampleRate();
+    auto& setup = audioProcessor.getGuiSetup();
+
+    // the columns only move when the rate does, so the tables are rebuilt just then;
+    // with oversampling the sections themselves are designed for a higher rate
+    if(sampleRate != displaySampleRate || setup.sampleRate != response.getSampleRate())
+    {
+        displaySampleRate = sampleRate;
+        for(int i = 0; i < freqs.size(); i++)
+            freqs.set(i, sampleRate/2.f * (1.0f - std::exp (std::log (1.0f - (float) i / (float) freqs.size()) * 0.1f)));
+
+        response.prepare(freqs.getRawDataPointer(), freqs.size(), setup.sampleRate);
+    }
+
+    if(response.update(setup))
+    {
+        updatePaths();
+        repaint(window);
+    }
+}
+
+void PhaseEQAudioProcessorEditor::updatePaths()
+{
+    int w  = window.getWidth() - 1;  // window width
+    int h  = window.getHeight() - 1; // window height
+    int l  = window.getX();          // window left
+    int b  = window.getY();          // window bottom
+    int t  = b + h;                  // window top
+    float yMax = 10.f;
+    float yMin = -10.f;
+    float delayMax = 10.f; // ms
+
+    auto magToCoord = [&](float db)
+    {
+        return juce::jlimit(float(b), float(t), b + juce::jmap(db, yMax, yMin, 0.f, float(h)));
+    };
+    auto phaseToCoord = [&](float v)
+    {
+        return juce::jlimit(float(b), float(t), b + juce::jmap(juce::radiansToDegrees(v), -180.f, 180.f, 0.f, float(h)));
+    };
+    auto delayToCoord = [&](float ms)
+    {
+        return juce::jlimit(float(b), float(t), b + juce::jmap(ms, delayMax, 0.f, 0.f, float(h)));
+    };
+
+    auto* mags = response.getMagnitudeDb();
+    auto* phases = response.getPhase();
+    auto* delays = response.getGroupDelayMs();
+    auto n = juce::jmin(w, response.getNumPoints() - 1);
+
+    magnitudePath.clear();
+    phasePath.clear();
+    groupDelayPath.clear();
+
+    if(n < 1)
+        return;
+
+    magnitudePath.preallocateSpace(3 * n);
+    phasePath.preallocateSpace(3 * n);
+    groupDelayPath.preallocateSpace(3 * n);
+    magnitudePath.startNewSubPath(float(l + 1), magToCoord(mags[1]));
+    phasePath.startNewSubPath(float(l + 1), phaseToCoord(phases[1]));
+    groupDelayPath.startNewSubPath(float(l + 1), delayToCoord(delays[1]));
+
+    for (int i = 2; i <= n; i++)
+    {
+        magnitudePath.lineTo(float(l + i), magToCoord(mags[i]));
+        phasePath.lineTo(float(l + i), phaseToCoord(phases[i]));
+        groupDelayPath.lineTo(float(l + i), delayToCoord(delays[i]));
+    }
+}
+
+void PhaseEQAudioProcessorEditor::updateSpectrumPaths()
+{
+    int w  = window.getWidth() - 1;  // window width
+    int h  = window.getHeight() - 1; // window height
+    int l  = window.getX();          // window left
+    int b  = window.getY();          // window bottom
+    int t  = b + h;                  // window top
+    float yMax = 6.f;
+    float yMin = SpectrumAnalyser::minDb;
+
+    auto dbToCoord = [&](float db)
+    {
+        return juce::jlimit(float(b), float(t), b + juce::jmap(db, yMax, yMin, 0.f, float(h)));
+    };
+
+    auto& pre = audioProcessor.getPreAnalyser();
+    auto& post = audioProcessor.getPostAnalyser();
+    auto n = juce::jmin(w, freqs.size() - 1);
+
+    preSpectrumPath.clear();
+    postSpectrumPath.clear();
+    peakPath.clear();
+
+    if(n < 1)
+        return;
+
+    preSpectrumPath.startNewSubPath(float(l + 1), dbToCoord(pre.getLevelAt(freqs[1])));
+    postSpectrumPath.startNewSubPath(float(l + 1), dbToCoord(post.getLevelAt(freqs[1])));
+    peakPath.startNewSubPath(float(l + 1), dbToCoord(post.getPeakAt(freqs[1])));
+
+    for (int i = 2; i <= n; i++)
+    {
+        preSpectrumPath.lineTo(float(l + i), dbToCoord(pre.getLevelAt(freqs[i])));
+        postSpectrumPath.lineTo(float(l + i), dbToCoord(post.getLevelAt(freqs[i])));
+        peakPath.lineTo(float(l + i), dbToCoord(post.getPeakAt(freqs[i])));
+    }
+}
+
+void PhaseEQAudioProcessorEditor::attachToBand(int band)
+{
+    using Attachment = juce::AudioProcessorValueTreeState;
+    auto& params = audioProcessor.getParameters();
+
+    // a control can only be attached to one parameter at a time, so drop the old ones first
+    freqAttachment.reset();
+    gainAttachment.reset();
+    qAttachment.reset();
+    filtersAttachment.reset();
+    channelsAttachment.reset();
+    routingAttachment.reset();
+    slopeAttachment.reset();
+    characteristicAttachment.reset();
+    enabledAttachment.reset();
+    dynamicAttachment.reset();
+    thresholdAttachment.reset();
+    ratioAttachment.reset();
+    attackAttachment.reset();
+    releaseAttachment.reset();
+    sidechainAttachment.reset();
+
+    freqAttachment      = std::make_unique<Attachment::SliderAttachment>  (params, ParameterIDs::band(ParameterIDs::freq, band)     , freqKnob);
+    gainAttachment      = std::make_unique<Attachment::SliderAttachment>  (params, ParameterIDs::band(ParameterIDs::gain, band)     , gainKnob);
+    qAttachment         = std::make_unique<Attachment::SliderAttachment>  (params, ParameterIDs::band(ParameterIDs::q, band)        , qKnob);
+    filtersAttachment   = std::make_unique<Attachment::ComboBoxAttachment>(params, ParameterIDs::band(ParameterIDs::type, band)     , filtersList);
+    channelsAttachment  = std::make_unique<Attachment::ComboBoxAttachment>(params, ParameterIDs::band(ParameterIDs::channels, band) , channelsList);
+    routingAttachment   = std::make_unique<Attachment::ComboBoxAttachment>(params, ParameterIDs::band(ParameterIDs::routing, band)  , routingList);
+    slopeAttachment     = std::make_unique<Attachment::ComboBoxAttachment>(params, ParameterIDs::band(ParameterIDs::slope, band)    , slopeList);
+    characteristicAttachment = std::make_unique<Attachment::ComboBoxAttachment>(params, ParameterIDs::band(ParameterIDs::characteristic, band), characteristicList);
+    enabledAttachment   = std::make_unique<Attachment::ButtonAttachment>  (params, ParameterIDs::band(ParameterIDs::enabled, band)  , enabledButton);
+    dynamicAttachment   = std::make_unique<Attachment::ButtonAttachment>  (params, ParameterIDs::band(ParameterIDs::dynamic, band)  , dynamicButton);
+    thresholdAttachment = std::make_unique<Attachment::SliderAttachment>  (params, ParameterIDs::band(ParameterIDs::threshold, band), thresholdKnob);
+    ratioAttachment     = std::make_unique<Attachment::SliderAttachment>  (params, ParameterIDs::band(ParameterIDs::ratio, band)    , ratioKnob);
+    attackAttachment    = std::make_unique<Attachment::SliderAttachment>  (params, ParameterIDs::band(ParameterIDs::attack, band)   , attackKnob);
+    releaseAttachment   = std::make_unique<Attachment::SliderAttachment>  (params, ParameterIDs::band(ParameterIDs::release, band)  , releaseKnob);
+    sidechainAttachment = std::make_unique<Attachment::ButtonAttachment>  (params, ParameterIDs::band(ParameterIDs::sidechain, band), sidechainButton);
+
+    updateSlopeControls();
+
+    // whatever was armed belonged to the band shown before
+    audioProcessor.getMidiControl().learn(-1);
+    learnList.setSelectedItemIndex(0, juce::dontSendNotification);
+    updateMidiLabel();
+}
+
+void PhaseEQAudioProcessorEditor::updateMidiLabel()
+{
+    auto& midi = audioProcessor.getMidiControl();
+    auto band = bandList.getSelectedItemIndex();
+    juce::StringArray names {"Freq", "Gain", "Q"};
+    juce::String text = "CC";
+
+    for(int target = 0; target < MidiControl::numTargets; target++)
+    {
+        auto controller = midi.getController(MidiControl::getMapping(band, target));
+        text << "  " << names[target] << " " << (controller < 0 ? juce::String("-") : juce::String(controller));
+    }
+
+    midiLabel.setText(text, juce::dontSendNotification);
+}
+
+void PhaseEQAudioProcessorEditor::updateSlopeControls()
+{
+    auto hasSlope = FilterDesign::hasSlope(filtersList.getSelectedItemIndex());
+    slopeList.setEnabled(hasSlope);
+    characteristicList.setEnabled(hasSlope);
+}
+
+void PhaseEQAudioProcessorEditor::updateLoudness()
+{
+    auto& autoGain = audioProcessor.getAutoGain();
+    juce::String text;
+
+    if(autoGainButton.getToggleState())
+    {
+        auto lufs = [](double loudness)
+        {
+            return loudness <= LoudnessMeter::silence ? juce::String("-") : juce::String(loudness, 1);
+        };
+
+        text << "In " << lufs(autoGain.getInputLoudness()) << "  Out " << lufs(autoGain.getOutputLoudness()) << " LUFS"
+             << "  Gain " << juce::String(autoGain.getTargetDb(), 1) << " dB" << (autoGain.isMeasured() ? "" : " (estimate)");
+    }
+
+    if(text != loudnessLabel.getText())
+        loudnessLabel.setText(text, juce::dontSendNotification);
+}
+
+void PhaseEQAudioProcessorEditor::chooseMatchFiles()
+{
+    if(matchJob != nullptr)
+        return;
+
+    auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+
+    // the reference first, then the file that should end up sounding like it. Each has its own chooser,
+    // since the first one is still running its callback when the second is launched
+    referenceChooser = std::make_unique<juce::FileChooser>("Reference to match", juce::File(), "*.wav;*.aiff;*.aif;*.flac");
+    referenceChooser->launchAsync(flags, [this, flags](const juce::FileChooser& fc)
+    {
+        auto reference = fc.getResult();
+        if(reference == juce::File())
+            return;
+
+        targetChooser = std::make_unique<juce::FileChooser>("Target to EQ", reference.getParentDirectory(), "*.wav;*.aiff;*.aif;*.flac");
+        targetChooser->launchAsync(flags, [this, reference](const juce::FileChooser& fc2)
+        {
+            auto target = fc2.getResult();
+            if(target == juce::File())
+                return;
+
+            auto sampleRate = audioProcessor.getSampleRate() > 0 ? audioProcessor.getSampleRate() : 48000.0;
+            matchJob = std::make_unique<MatchEQ::Job>(reference, target, sampleRate);
+            matchJob->startThread();
+            matchButton.setEnabled(false);
+            matchLabel.setText("Analysing...", juce::dontSendNotification);
+        });
+    });
+}
+
+void PhaseEQAudioProcessorEditor::updateMatch()
+{
+    if(matchJob == nullptr || matchJob->isThreadRunning())
+        return;
+
+    auto& status = matchJob->getStatus();
+
+    if(status.wasOk())
+    {
+        auto& result = matchJob->getResult();
+        MatchEQ::apply(result, audioProcessor.getParameters());
+        audioProcessor.setUpdate(true);
+        matchLabel.setText(juce::String(result.numBands) + " bands, " + juce::String(result.initialErrorDb, 1) + " -> "
+                           + juce::String(result.errorDb, 1) + " dB RMS", juce::dontSendNotification);
+    }
+    else
+    {
+        matchLabel.setText(status.getErrorMessage(), juce::dontSendNotification);
+    }
+
+    matchJob.reset();
+    matchButton.setEnabled(true);
+}
+
+void PhaseEQAudioProcessorEditor::updateStats()
+{
+    auto& monitor = audioProcessor.getPerformanceMonitor();
+
+    // a new snapshot arrives a few times a second while audio runs
+    if(statsButton.getToggleState() && monitor.update())
+    {
+        statsText = monitor.getSnapshot().toString() + "  " + audioProcessor.getDesignCache().getStats().toString();
+        repaint(window);
+    }
+}
+
+void PhaseEQAudioProcessorEditor::resized()
+{
+}
+
+void PhaseEQAudioProcessorEditor::timerCallback()
+{
+    // learning finished on the audio thread
+    if(learnList.getSelectedItemIndex() > 0 && audioProcessor.getMidiControl().getLearning() < 0)
+    {
+        learnList.setSelectedItemIndex(0, juce::dontSendNotification);
+        updateMidiLabel();
+    }
+
+    if(audioProcessor.checkForUpdates())
+    {
+        updateResponse();
+        audioProcessor.setUpdateGUI(false);
+    }
+
+    updateStats();
+    updateLoudness();
+    updateMatch();
+
+    auto preChanged = audioProcessor.getPreAnalyser().process();
+    auto postChanged = audioProcessor.getPostAnalyser().process();
+
+    if(preChanged || postChanged)
+    {
+        updateSpectrumPaths();
+        repaint(window);
+    }
+}
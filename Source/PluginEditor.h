@@ -1,44 +1,70 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-
-//==============================================================================
-/**
-*/
-class PhaseEQAudioProcessorEditor  : public juce::AudioProcessorEditor, juce::Timer
-{
-public:
-    PhaseEQAudioProcessorEditor (PhaseEQAudioProcessor&);
-    ~PhaseEQAudioProcessorEditor() override;
-
-    //==============================================================================
-    void paint (juce::Graphics&) override;
-    void resized() override;
-
-    void plot(juce::Graphics& g);
-
-
-private:
-    void timerCallback() override;
-    PhaseEQAudioProcessor& audioProcessor;
-    juce::Rectangle<int> window;
-    juce::Array<double> freqs;
-    juce::Array<double> mags;
-    juce::Array<double> phases;
-    juce::Slider freqKnob, gainKnob, qKnob;
-    juce::ComboBox filtersList;
-    juce::Label freqLabel, gainLabel, qLabel, filtersLabel;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> freqAttachment, gainAttachment, qAttachment;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> filtersAttachment;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhaseEQAudioProcessorEditor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "ResponseCurve.h"
+#include "MatchEQ.h"
+
+//==============================================================================
+/**
+*/
+class PhaseEQAudioProcessorEditor  : public juce::AudioProcessorEditor, juce::Timer
+{
+public:
+    PhaseEQAudioProcessorEditor (PhaseEQAudioProcessor&);
+    ~PhaseEQAudioProcessorEditor() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+    void plot(juce::Graphics& g);
+
+
+private:
+    void timerCallback() override;
+    void attachToBand(int band);
+    void updateResponse();
+    void updatePaths();
+    void updateSpectrumPaths();
+    void updateMidiLabel();
+    void updateStats();
+    void updateSlopeControls();
+    void updateLoudness();
+    void chooseMatchFiles();
+    void updateMatch();
+
+    PhaseEQAudioProcessor& audioProcessor;
+    juce::Rectangle<int> window;
+    juce::Array<double> freqs;
+    double displaySampleRate = 0.0;
+    ResponseCurve response;
+    juce::Path magnitudePath, phasePath, groupDelayPath;
+    juce::Path preSpectrumPath, postSpectrumPath, peakPath;
+    juce::Slider freqKnob, gainKnob, qKnob, smoothingKnob;
+    juce::Slider thresholdKnob, ratioKnob, attackKnob, releaseKnob, correctionLowKnob, correctionHighKnob;
+    juce::ComboBox filtersList, channelsList, routingList, bandList, phaseModeList, oversamplingList, oversamplingQualityList, learnList, slopeList, characteristicList;
+    juce::ToggleButton enabledButton {"On"}, dynamicButton {"Dynamic"}, sidechainButton {"Sidechain"};
+    juce::TextButton forgetButton {"Forget CCs"};
+    juce::ToggleButton statsButton {"Stats"};
+    juce::ToggleButton autoGainButton {"Auto Gain"};
+    juce::TextButton matchButton {"Match EQ..."};
+    juce::String statsText;
+    juce::Label freqLabel, gainLabel, qLabel, filtersLabel, channelsLabel, routingLabel, bandLabel, smoothingLabel, thresholdLabel, ratioLabel, attackLabel, releaseLabel, correctionLowLabel, correctionHighLabel, phaseModeLabel, oversamplingLabel, oversamplingQualityLabel, learnLabel, midiLabel, loudnessLabel, matchLabel;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> freqAttachment, gainAttachment, qAttachment, smoothingAttachment, correctionLowAttachment, correctionHighAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> thresholdAttachment, ratioAttachment, attackAttachment, releaseAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> filtersAttachment, channelsAttachment, routingAttachment, slopeAttachment, characteristicAttachment, phaseModeAttachment, oversamplingAttachment, oversamplingQualityAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> enabledAttachment, dynamicAttachment, sidechainAttachment, autoGainAttachment;
+    std::unique_ptr<juce::FileChooser> referenceChooser, targetChooser;
+    std::unique_ptr<MatchEQ::Job> matchJob;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhaseEQAudioProcessorEditor)
+};
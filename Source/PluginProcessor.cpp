@@ -1,244 +1,649 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-PhaseEQAudioProcessor::PhaseEQAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       ),
-                    parameters(*this, nullptr, "Parameters", createParameters())
-#endif
-{
-}
-
-PhaseEQAudioProcessor::~PhaseEQAudioProcessor()
-{
-}
-
-//==============================================================================
-const juce::String PhaseEQAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool PhaseEQAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool PhaseEQAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool PhaseEQAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double PhaseEQAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int PhaseEQAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int PhaseEQAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void PhaseEQAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String PhaseEQAudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void PhaseEQAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void PhaseEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.sampleRate = sampleRate;
-    spec.numChannels = getTotalNumInputChannels();
-
-    filter.prepare(spec);
-
-    setUpdate(true);
-}
-
-void PhaseEQAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool PhaseEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-void PhaseEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
-
-    if(requiresUpdate)
-    {
-        updateParameters();
-    }
-
-    auto block = juce::dsp::AudioBlock<float>(buffer);
-    filter.process(juce::dsp::ProcessContextReplacing<float>(block));
-}
-
-void PhaseEQAudioProcessor::updateParameters()
-{
-    setUpdateGUI(false);
-    float freq = *parameters.getRawParameterValue("FREQ");
-    float gain = *parameters.getRawParameterValue("GAIN");
-    float q = *parameters.getRawParameterValue("Q");
-    int filterChoice = *parameters.getRawParameterValue("FILTERS");
-
-    switch(filterChoice)
-    {
-        case 0:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), freq, q, juce::Decibels::decibelsToGain(gain));
-            break;
-        case 1:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), freq, q);
-            break;
-        case 2:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makeHighPass(getSampleRate(), freq, q);
-            break;
-        case 3:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makeBandPass(getSampleRate(), freq, q);
-            break;
-        case 4:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makeNotch(getSampleRate(), freq, q);
-            break;
-        case 5:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makeAllPass(getSampleRate(), freq, q);
-            break;
-        case 6:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makeLowShelf(getSampleRate(), freq, q, juce::Decibels::decibelsToGain(gain));
-            break;
-        case 7:
-            *filter.state = *juce::dsp::IIR::Coefficients<float>::makeHighShelf(getSampleRate(), freq, q, juce::Decibels::decibelsToGain(gain));
-            break;
-        default:
-            jassert(false);
-    }
-
-    setUpdateGUI(true);
-    setUpdate(false);
-}
-
-juce::AudioProcessorValueTreeState::ParameterLayout PhaseEQAudioProcessor::createParameters()
-{
-    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
-    params.push_back(std::make_unique<juce::AudioParameterFloat>("FREQ"   , "Freq"   , juce::NormalisableRange<float>(30.f , 20000.f, 0.001f, 0.2f), 1000.f));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>("GAIN"   , "Gain"   , juce::NormalisableRange<float>(-10.f, 10.f   , 0.001f      ), 0.f   ));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>("Q"      , "Q"      , juce::NormalisableRange<float>(0.1f , 18.f   , 0.001f      ), .707f ));
-    params.push_back(std::make_unique<juce::AudioParameterChoice>("FILTERS", "Filters", filtersList, 0));
-    return { params.begin(), params.end() };
-}
-
-//==============================================================================
-bool PhaseEQAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* PhaseEQAudioProcessor::createEditor()
-{
-    return new PhaseEQAudioProcessorEditor (*this);
-}
-
-//==============================================================================
-void PhaseEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    std::unique_ptr<juce::XmlElement> xml(parameters.state.createXml());
-    copyXmlToBinary(*xml, destData);
-}
-
-void PhaseEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
-
-    if(xmlState.get() != nullptr)
-    {
-        if(xmlState->hasTagName(parameters.state.getType()))
-        {
-            parameters.state = juce::ValueTree::fromXml(*xmlState);
-        }
-    }
-    setUpdate(true);
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new PhaseEQAudioProcessor();
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+//==============================================================================
+PhaseEQAudioProcessor::PhaseEQAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       ),
+                    parameters(*this, nullptr, "Parameters", createParameters()),
+                    designer(parameters),
+                    midiControl(parameters)
+#endif
+{
+    for(auto* param : AudioProcessor::getParameters())
+        if(auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            stateParameters.add(ranged);
+
+    smoothingParam = parameters.getRawParameterValue(ParameterIDs::smoothing);
+    controlIntervalParam = parameters.getRawParameterValue(ParameterIDs::controlInterval);
+    autoGainParam = parameters.getRawParameterValue(ParameterIDs::autoGain);
+
+    // latency and tail changes are reported from the message thread
+    designer.setHostInfoCallback([this] {triggerAsyncUpdate();});
+}
+
+PhaseEQAudioProcessor::~PhaseEQAudioProcessor()
+{
+    designer.setHostInfoCallback(nullptr);
+    cancelPendingUpdate();
+}
+
+//==============================================================================
+const juce::String PhaseEQAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool PhaseEQAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool PhaseEQAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool PhaseEQAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double PhaseEQAudioProcessor::getTailLengthSeconds() const
+{
+    auto sampleRate = getSampleRate();
+    return sampleRate > 0.0 ? designer.getTailSamples() / sampleRate : 0.0;
+}
+
+int PhaseEQAudioProcessor::getNumPrograms()
+{
+    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                // so this should be at least 1, even if you're not really implementing programs.
+}
+
+int PhaseEQAudioProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+void PhaseEQAudioProcessor::setCurrentProgram (int index)
+{
+}
+
+const juce::String PhaseEQAudioProcessor::getProgramName (int index)
+{
+    return {};
+}
+
+void PhaseEQAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+}
+
+//==============================================================================
+void PhaseEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    juce::dsp::ProcessSpec spec;
+    spec.maximumBlockSize = samplesPerBlock;
+    spec.sampleRate = sampleRate;
+    spec.numChannels = getMainBusNumInputChannels();
+
+    convolver.prepare(spec);
+    dynamics.reset();
+    silentSamples = 0;
+    idle = false;
+
+    // only the precision the host asked for is allocated
+    if(isUsingDoublePrecision())
+    {
+        prepareEngine(doubleEngine, spec);
+        convolverBuffer.setSize((int) spec.numChannels, samplesPerBlock);
+    }
+    else
+    {
+        prepareEngine(floatEngine, spec);
+        convolverBuffer.setSize(0, 0);
+    }
+
+    preAnalyser.setSampleRate(sampleRate);
+    postAnalyser.setSampleRate(sampleRate);
+    monitor.prepare(sampleRate);
+    autoGain.prepare(sampleRate, getChannelLayoutOfBus(true, 0));
+
+    designer.setChannelLayout(getChannelLayoutOfBus(true, 0));
+    designer.setSampleRate(sampleRate);
+    designer.designIfNeeded();
+    updateParameters();
+    setLatencySamples(designer.getLatencySamples());
+}
+
+template <typename SampleType>
+void PhaseEQAudioProcessor::prepareEngine(Engine<SampleType>& engine, const juce::dsp::ProcessSpec& spec)
+{
+    engine.oversampler.prepare(spec);
+    engine.oversampler.reset();
+
+    // the cascade may run on blocks up to the highest oversampling factor
+    auto oversampledSpec = spec;
+    oversampledSpec.maximumBlockSize = spec.maximumBlockSize << Oversampler<SampleType>::maxOrder;
+    engine.cascade.prepare(oversampledSpec);
+    engine.cascade.reset();
+}
+
+void PhaseEQAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool PhaseEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // any discrete, surround or ambisonic layout, as long as the cascade's channel masks can address it
+    auto output = layouts.getMainOutputChannelSet();
+    if (output.isDisabled() || output.size() > CascadeSetup::maxChannels)
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (output != layouts.getMainInputChannelSet())
+        return false;
+
+    // the sidechain is mixed to mono for the detectors, so any width will do
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet(true, 1).size() > CascadeSetup::maxChannels)
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void PhaseEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, midiMessages, floatEngine);
+}
+
+void PhaseEQAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process(buffer, midiMessages, doubleEngine);
+}
+
+bool PhaseEQAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void PhaseEQAudioProcessor::process (juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages, Engine<SampleType>& engine)
+{
+    juce::ScopedNoDenormals noDenormals;
+    PerformanceMonitor::ScopedBlock timing(monitor, buffer.getNumSamples());
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    // offline renders can't rely on the designer thread keeping up, so design inline
+    if(isNonRealtime())
+        designer.designIfNeeded();
+
+    updateParameters(engine);
+
+    // the sidechain, if the host connected one, follows the main bus in the same buffer. Blocks rather
+    // than getBusBuffer() views: an AudioBuffer view allocates its channel array past 32 channels
+    auto hostBlock = juce::dsp::AudioBlock<SampleType>(buffer);
+    auto mainBlock = hostBlock.getSubsetChannelBlock(0, (size_t) getChannelCountOfBus(true, 0));
+    preAnalyser.pushSamples(mainBlock);
+
+    if(isIdle(mainBlock, engine))
+    {
+        // controllers still move their parameters, there's just nothing to filter
+        for(const auto metadata : midiMessages)
+        {
+            auto message = metadata.getMessage();
+            if(message.isController() && midiControl.handleController(message) >= 0)
+                designer.triggerUpdate();
+        }
+
+        mainBlock.clear();
+        postAnalyser.pushSamples(mainBlock);
+        return;
+    }
+
+    // the input is metered before anything touches it
+    autoGain.setEnabled(autoGainParam->load() > 0.5f);
+    autoGain.pushInput(mainBlock);
+
+    // a mapped controller splits the block, so its change lands on the exact sample it was sent for;
+    // without any, the whole block runs in one go as before
+    auto numSamples = (int) mainBlock.getNumSamples();
+    auto start = 0;
+
+    for(const auto metadata : midiMessages)
+    {
+        auto message = metadata.getMessage();
+        if(! message.isController() || ! midiControl.isMapped(message.getControllerNumber()))
+            continue;
+
+        auto position = juce::jlimit(start, numSamples, metadata.samplePosition);
+        processRange(hostBlock, start, position - start, engine);
+        start = position;
+
+        applyController(message, engine);
+    }
+
+    processRange(hostBlock, start, numSamples - start, engine);
+
+    autoGain.process(mainBlock);
+    if(isNonRealtime())
+        autoGain.update();
+
+    postAnalyser.pushSamples(mainBlock);
+}
+
+template <typename SampleType>
+void PhaseEQAudioProcessor::processRange(const juce::dsp::AudioBlock<SampleType>& hostBlock, int start, int numSamples, Engine<SampleType>& engine)
+{
+    if(numSamples <= 0)
+        return;
+
+    // views into the host's buffer, nothing is copied or allocated
+    auto block = hostBlock.getSubsetChannelBlock(0, (size_t) getChannelCountOfBus(true, 0))
+                          .getSubBlock((size_t) start, (size_t) numSamples);
+    auto runCascade = [&engine](juce::dsp::AudioBlock<SampleType>& oversampled)
+    {
+        engine.cascade.process(juce::dsp::ProcessContextReplacing<SampleType>(oversampled));
+    };
+
+    if(linearPhase)
+    {
+        processLinearPhase(block);
+    }
+    else if(! dynamics.isActive())
+    {
+        engine.oversampler.process(block, runCascade);
+    }
+    else
+    {
+        // the detectors set the dynamic bands' gains once per control interval, and the cascade glides in between
+        auto sidechain = juce::dsp::AudioBlock<SampleType>();
+        if(getChannelCountOfBus(true, 1) > 0)
+            sidechain = hostBlock.getSubsetChannelBlock((size_t) getChannelIndexInProcessBlockBuffer(true, 1, 0), (size_t) getChannelCountOfBus(true, 1))
+                                 .getSubBlock((size_t) start, (size_t) numSamples);
+        auto interval = (size_t) (8 << (int) controlIntervalParam->load());
+
+        for(size_t offset = 0; offset < block.getNumSamples(); offset += interval)
+        {
+            auto length = juce::jmin(interval, block.getNumSamples() - offset);
+            auto subBlock = block.getSubBlock(offset, length);
+            auto subSidechain = sidechain.getNumChannels() > 0 ? sidechain.getSubBlock(offset, length) : sidechain;
+
+            dynamics.process(subBlock, subSidechain, engine.cascade, (int) length << engine.oversampler.getOrder());
+            engine.oversampler.process(subBlock, runCascade);
+        }
+    }
+}
+
+template <typename SampleType>
+void PhaseEQAudioProcessor::applyController(const juce::MidiMessage& message, Engine<SampleType>& engine)
+{
+    auto band = midiControl.handleController(message);
+    if(band < 0)
+        return;
+
+    // the parameter only tells its listeners later, from the message thread
+    designer.triggerUpdate();
+
+    // the sections move right here, gliding like any other change if smoothing is on
+    std::array<BiquadCoefficients, CoefficientDesigner::slotsPerBand> coefficients;
+    auto numSections = linearPhase ? 0 : designer.designBand(band, designRate, coefficients.data());
+
+    for(int i = 0; i < numSections; i++)
+        engine.cascade.setSectionTarget(CoefficientDesigner::getBandSlot(band) + i, coefficients[(size_t) i], (int) (designRate * smoothingParam->load() * 0.001));
+
+    if(numSections > 0)
+        monitor.countRedesign();
+}
+
+template <typename SampleType>
+bool PhaseEQAudioProcessor::isIdle(const juce::dsp::AudioBlock<SampleType>& block, Engine<SampleType>& engine)
+{
+    auto numSamples = (int) block.getNumSamples();
+    auto range = block.findMinAndMax();
+
+    if(juce::jmax(-range.getStart(), range.getEnd()) > (SampleType) silenceThreshold)
+    {
+        silentSamples = 0;
+        idle = false;
+        return false;
+    }
+
+    if(idle)
+        return true;
+
+    silentSamples += numSamples;
+
+    // once the last input has come out and rung down below the threshold, dropping the state is inaudible
+    if(silentSamples <= designer.getLatencySamples() + designer.getTailSamples())
+        return false;
+
+    engine.cascade.reset();
+    engine.oversampler.reset();
+    convolver.reset();
+    dynamics.reset();
+    idle = true;
+    return true;
+}
+
+void PhaseEQAudioProcessor::processLinearPhase(juce::dsp::AudioBlock<float>& block)
+{
+    convolver.process(juce::dsp::ProcessContextReplacing<float>(block));
+}
+
+void PhaseEQAudioProcessor::processLinearPhase(juce::dsp::AudioBlock<double>& block)
+{
+    auto numChannels = juce::jmin((int) block.getNumChannels(), convolverBuffer.getNumChannels());
+    auto maxBlockSize = convolverBuffer.getNumSamples();
+
+    if(maxBlockSize == 0)
+        return;
+
+    // round trip through float, in chunks that fit the buffer allocated in prepareToPlay
+    for(int start = 0; start < (int) block.getNumSamples(); start += maxBlockSize)
+    {
+        auto numSamples = juce::jmin(maxBlockSize, (int) block.getNumSamples() - start);
+
+        for(int ch = 0; ch < numChannels; ch++)
+        {
+            auto* src = block.getChannelPointer((size_t) ch) + start;
+            auto* dest = convolverBuffer.getWritePointer(ch);
+            for(int i = 0; i < numSamples; i++)
+                dest[i] = (float) src[i];
+        }
+
+        auto floatBlock = juce::dsp::AudioBlock<float>(convolverBuffer).getSubBlock(0, (size_t) numSamples);
+        convolver.process(juce::dsp::ProcessContextReplacing<float>(floatBlock));
+
+        for(int ch = 0; ch < numChannels; ch++)
+        {
+            auto* src = convolverBuffer.getReadPointer(ch);
+            auto* dest = block.getChannelPointer((size_t) ch) + start;
+            for(int i = 0; i < numSamples; i++)
+                dest[i] = src[i];
+        }
+    }
+}
+
+void PhaseEQAudioProcessor::updateParameters()
+{
+    if(isUsingDoublePrecision())
+        updateParameters(doubleEngine);
+    else
+        updateParameters(floatEngine);
+}
+
+template <typename SampleType>
+void PhaseEQAudioProcessor::updateParameters(Engine<SampleType>& engine)
+{
+    auto& kernels = designer.getKernels();
+    if(kernels.update() && kernels.getReadBuffer() != nullptr)
+    {
+        convolver.setKernel(kernels.getReadBuffer());
+        monitor.countRedesign();
+    }
+
+    auto& slot = designer.getAudioCoefficients();
+
+    if(! slot.update())
+        return;
+
+    monitor.countRedesign();
+    auto& setup = slot.getReadBuffer();
+
+    designRate = setup.sampleRate;
+
+    // ramp length and control interval only matter when a new set of coefficients arrives
+    auto rampLength = (int) (setup.sampleRate * smoothingParam->load() * 0.001);
+    auto interval = 8 << (int) controlIntervalParam->load();
+
+    // whichever path takes over starts from silence rather than stale state
+    if(setup.linearPhase != linearPhase)
+    {
+        linearPhase = setup.linearPhase;
+        if(linearPhase)
+            convolver.reset();
+        else
+            engine.cascade.reset();
+    }
+
+    // coefficients designed for another rate can't be glided into
+    if(setup.oversamplingOrder != engine.oversampler.getOrder() || setup.oversamplingQuality != engine.oversampler.getQuality())
+    {
+        engine.oversampler.setMode(setup.oversamplingOrder, setup.oversamplingQuality);
+        engine.cascade.reset();
+        rampLength = 0;
+    }
+
+    engine.cascade.setSmoothing(rampLength, interval);
+    engine.cascade.setSetup(setup);
+    dynamics.setSetup(setup, engine.cascade, rampLength);
+    autoGain.setEstimate(setup.loudnessChangeDb);
+}
+
+bool PhaseEQAudioProcessor::checkForUpdates()
+{
+    if(designer.getGuiCoefficients().update())
+        guiNeedsUpdate = true;
+
+    return guiNeedsUpdate;
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout PhaseEQAudioProcessor::createParameters()
+{
+    const float defaultFreqs[ParameterIDs::numBands] = {50.f, 120.f, 300.f, 1000.f, 2500.f, 5000.f, 8000.f, 12000.f};
+
+    std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
+    for(int i = 0; i < ParameterIDs::numBands; i++)
+    {
+        using namespace ParameterIDs;
+        auto name = juce::String(i + 1) + " ";
+        params.push_back(std::make_unique<juce::AudioParameterBool>  (band(enabled, i), name + "On"     , false));
+        params.push_back(std::make_unique<juce::AudioParameterFloat> (band(freq, i)   , name + "Freq"   , juce::NormalisableRange<float>(30.f , 20000.f, 0.001f, 0.2f), defaultFreqs[i]));
+        params.push_back(std::make_unique<juce::AudioParameterFloat> (band(gain, i)   , name + "Gain"   , juce::NormalisableRange<float>(-10.f, 10.f   , 0.001f      ), 0.f   ));
+        params.push_back(std::make_unique<juce::AudioParameterFloat> (band(q, i)      , name + "Q"      , juce::NormalisableRange<float>(0.1f , 18.f   , 0.001f      ), .707f ));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(band(type, i)   , name + "Filters", filtersList, 0));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(band(channels, i), name + "Channels", channelsList, 0));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(band(routing, i) , name + "Routing" , routingList, 0));
+        params.push_back(std::make_unique<juce::AudioParameterBool>  (band(dynamic, i)  , name + "Dynamic"  , false));
+        params.push_back(std::make_unique<juce::AudioParameterFloat> (band(threshold, i), name + "Threshold", juce::NormalisableRange<float>(-60.f, 0.f   , 0.1f        ), -20.f ));
+        params.push_back(std::make_unique<juce::AudioParameterFloat> (band(ratio, i)    , name + "Ratio"    , juce::NormalisableRange<float>(1.f  , 20.f  , 0.01f, 0.4f ), 2.f   ));
+        params.push_back(std::make_unique<juce::AudioParameterFloat> (band(attack, i)   , name + "Attack"   , juce::NormalisableRange<float>(0.1f , 200.f , 0.01f, 0.4f ), 10.f  ));
+        params.push_back(std::make_unique<juce::AudioParameterFloat> (band(release, i)  , name + "Release"  , juce::NormalisableRange<float>(5.f  , 2000.f, 0.1f , 0.4f ), 100.f ));
+        params.push_back(std::make_unique<juce::AudioParameterBool>  (band(sidechain, i), name + "Sidechain", false));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(band(slope, i)         , name + "Slope"         , slopesList, 1));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(band(characteristic, i), name + "Characteristic", characteristicsList, 0));
+    }
+    params.push_back(std::make_unique<juce::AudioParameterFloat> (ParameterIDs::smoothing      , "Smoothing"       , juce::NormalisableRange<float>(0.f, 500.f, 0.1f, 0.5f), 20.f));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(ParameterIDs::controlInterval, "Control Interval", juce::StringArray {"8", "16", "32", "64"}, 2));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(ParameterIDs::phaseMode      , "Phase Mode"      , juce::StringArray {"Minimum", "Linear", "Corrected"}, 0));
+    params.push_back(std::make_unique<juce::AudioParameterFloat> (ParameterIDs::correctionLow  , "Correction Low"  , juce::NormalisableRange<float>(20.f, 20000.f, 0.001f, 0.2f), 20.f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat> (ParameterIDs::correctionHigh , "Correction High" , juce::NormalisableRange<float>(20.f, 20000.f, 0.001f, 0.2f), 1000.f));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(ParameterIDs::oversampling   , "Oversampling"    , juce::StringArray {"Off", "2x", "4x", "8x"}, 0));
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(ParameterIDs::oversamplingQuality, "Oversampling Quality", juce::StringArray {"Efficient", "Linear Phase"}, 0));
+    params.push_back(std::make_unique<juce::AudioParameterBool>  (ParameterIDs::autoGain       , "Auto Gain"       , false));
+    return { params.begin(), params.end() };
+}
+
+//==============================================================================
+bool PhaseEQAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* PhaseEQAudioProcessor::createEditor()
+{
+    return new PhaseEQAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+void PhaseEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // controllers that moved since the last timer tick have only changed the raw values so far
+    midiControl.flushPendingValues();
+
+    // magic, version, then every parameter's ID and real value - no XML to build or parse
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(stateMagic);
+    stream.writeInt(stateVersion);
+    stream.writeCompressedInt(stateParameters.size());
+
+    for(auto* param : stateParameters)
+    {
+        stream.writeString(param->paramID);
+        stream.writeFloat(param->convertFrom0to1(param->getValue()));
+    }
+
+    midiControl.writeTo(stream);
+}
+
+void PhaseEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    if(! readBinaryState(data, sizeInBytes))
+    {
+        midiControl.clear();
+
+        // sessions saved before the binary format
+        std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
+
+        if(xmlState.get() != nullptr)
+        {
+            if(xmlState->hasTagName(parameters.state.getType()))
+            {
+                auto state = juce::ValueTree::fromXml(*xmlState);
+                importLegacyState(state);
+                parameters.replaceState(state);
+            }
+        }
+    }
+    setUpdate(true);
+}
+
+bool PhaseEQAudioProcessor::readBinaryState(const void* data, int sizeInBytes)
+{
+    if(data == nullptr || sizeInBytes < 8)
+        return false;
+
+    juce::MemoryInputStream stream(data, (size_t) sizeInBytes, false);
+
+    // later versions may only append after the parameter list, so any version can be read
+    if(stream.readInt() != stateMagic)
+        return false;
+
+    auto version = stream.readInt();
+    if(version < 1)
+        return false;
+
+    std::vector<bool> restored((size_t) stateParameters.size(), false);
+    auto numStored = stream.readCompressedInt();
+
+    for(int i = 0; i < numStored && ! stream.isExhausted(); i++)
+    {
+        auto id = stream.readString();
+        auto value = stream.readFloat();
+
+        // saved in the same order as long as no parameter was added or removed in between
+        auto index = i < stateParameters.size() && stateParameters.getUnchecked(i)->paramID == id
+                   ? i : stateParameters.indexOf(dynamic_cast<juce::RangedAudioParameter*>(parameters.getParameter(id)));
+
+        if(index < 0)
+            continue;
+
+        auto* param = stateParameters.getUnchecked(index);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+        restored[(size_t) index] = true;
+    }
+
+    // parameters the session didn't know about yet start from their defaults
+    for(int i = 0; i < stateParameters.size(); i++)
+        if(! restored[(size_t) i])
+            stateParameters.getUnchecked(i)->setValueNotifyingHost(stateParameters.getUnchecked(i)->getDefaultValue());
+
+    if(version >= 2)
+        midiControl.readFrom(stream);
+    else
+        midiControl.clear();
+
+    return true;
+}
+
+void PhaseEQAudioProcessor::importLegacyState(juce::ValueTree& state)
+{
+    // sessions saved before the multi-band engine had a single, always active band
+    bool isLegacy = false;
+    for(auto child : state)
+    {
+        auto id = child.getProperty("id").toString();
+        for(auto* name : {ParameterIDs::type, ParameterIDs::freq, ParameterIDs::gain, ParameterIDs::q})
+        {
+            if(id == name)
+            {
+                child.setProperty("id", ParameterIDs::band(name, 0), nullptr);
+                isLegacy = true;
+            }
+        }
+    }
+
+    if(isLegacy)
+    {
+        juce::ValueTree enabled("PARAM");
+        enabled.setProperty("id", ParameterIDs::band(ParameterIDs::enabled, 0), nullptr);
+        enabled.setProperty("value", 1.f, nullptr);
+        state.appendChild(enabled, nullptr);
+    }
+}
+
+void PhaseEQAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(designer.getLatencySamples());
+    updateHostDisplay();
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new PhaseEQAudioProcessor();
+}
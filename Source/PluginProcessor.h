@@ -1,78 +1,148 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-
-//==============================================================================
-/**
-*/
-class PhaseEQAudioProcessor  : public juce::AudioProcessor
-{
-public:
-    //==============================================================================
-    PhaseEQAudioProcessor();
-    ~PhaseEQAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-   #ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
-
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-
-    juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
-    juce::AudioProcessorValueTreeState& getParameters() {return parameters;}
-
-    /* my functions */
-    inline void setUpdate(bool v) {requiresUpdate = v;}
-    inline void setUpdateGUI(bool v) {guiNeedsUpdate = v;}
-    inline bool checkForUpdates() {return guiNeedsUpdate;}
-    inline void getFreqResponse(double * freqArray, double * mags, size_t n) {filter.state->getMagnitudeForFrequencyArray(freqArray, mags, n, getSampleRate());}
-    inline void getPhaseResponse(double * freqArray, double * phs, size_t n) {filter.state->getPhaseForFrequencyArray(freqArray, phs, n, getSampleRate());}
-    inline juce::StringArray getFiltersList() {return filtersList;}
-
-    void updateParameters();
-
-private:
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> filter;
-    juce::StringArray filtersList {"Peak", "Low Pass", "High Pass", "Band Pass", "Notch", "All Pass", "Low Shelf", "High Shelf"};
-    bool requiresUpdate;
-    bool guiNeedsUpdate;
-    juce::AudioProcessorValueTreeState parameters;
-
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhaseEQAudioProcessor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientDesigner.h"
+#include "SpectrumAnalyser.h"
+#include "DynamicBands.h"
+#include "MidiControl.h"
+#include "PerformanceMonitor.h"
+#include "AutoGain.h"
+
+//==============================================================================
+/**
+*/
+class PhaseEQAudioProcessor  : public juce::AudioProcessor,
+                               private juce::AsyncUpdater
+{
+public:
+    //==============================================================================
+    PhaseEQAudioProcessor();
+    ~PhaseEQAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+   #ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+   #endif
+
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+
+    juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
+    juce::AudioProcessorValueTreeState& getParameters() {return parameters;}
+
+    /* my functions */
+    inline void setUpdate(bool v) {if(v) designer.triggerUpdate();}
+    inline void setUpdateGUI(bool v) {guiNeedsUpdate = v;}
+    bool checkForUpdates();
+    inline const CascadeSetup& getGuiSetup() {return designer.getGuiCoefficients().getReadBuffer();}
+    inline double getDesignSampleRate() const {return designer.getSampleRate();}
+    inline juce::StringArray getFiltersList() {return filtersList;}
+    inline juce::StringArray getChannelsList() {return channelsList;}
+    inline juce::StringArray getRoutingList() {return routingList;}
+    inline juce::StringArray getSlopesList() {return slopesList;}
+    inline juce::StringArray getCharacteristicsList() {return characteristicsList;}
+    inline SpectrumAnalyser& getPreAnalyser() {return preAnalyser;}
+    inline SpectrumAnalyser& getPostAnalyser() {return postAnalyser;}
+    inline MidiControl& getMidiControl() {return midiControl;}
+    inline PerformanceMonitor& getPerformanceMonitor() {return monitor;}
+    inline DesignCache& getDesignCache() {return designer.getCache();}
+    inline AutoGain& getAutoGain() {return autoGain;}
+
+    void updateParameters();
+
+private:
+    /** Everything on the minimum phase path, in the precision the host processes in. */
+    template <typename SampleType>
+    struct Engine
+    {
+        FilterCascade<SampleType> cascade;
+        Oversampler<SampleType> oversampler;
+    };
+
+    template <typename SampleType>
+    void prepareEngine(Engine<SampleType>& engine, const juce::dsp::ProcessSpec& spec);
+    template <typename SampleType>
+    void updateParameters(Engine<SampleType>& engine);
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, juce::MidiBuffer& midiMessages, Engine<SampleType>& engine);
+    template <typename SampleType>
+    void processRange(const juce::dsp::AudioBlock<SampleType>& hostBlock, int start, int numSamples, Engine<SampleType>& engine);
+    template <typename SampleType>
+    void applyController(const juce::MidiMessage& message, Engine<SampleType>& engine);
+    template <typename SampleType>
+    bool isIdle(const juce::dsp::AudioBlock<SampleType>& block, Engine<SampleType>& engine);
+    void processLinearPhase(juce::dsp::AudioBlock<float>& block);
+    void processLinearPhase(juce::dsp::AudioBlock<double>& block);
+
+    bool readBinaryState(const void* data, int sizeInBytes);
+    void importLegacyState(juce::ValueTree& state);
+    void handleAsyncUpdate() override;
+
+    Engine<float> floatEngine;
+    Engine<double> doubleEngine;
+    DynamicBands dynamics;
+    PartitionedConvolver convolver;
+    juce::AudioBuffer<float> convolverBuffer; // the FFT is single precision only
+    SpectrumAnalyser preAnalyser, postAnalyser;
+    PerformanceMonitor monitor;
+    AutoGain autoGain;
+    bool linearPhase = false;
+    double designRate = 0.0; // of the setup the cascade currently runs
+    bool idle = false;
+    int silentSamples = 0;
+    static constexpr float silenceThreshold = 1.0e-6f; // -120 dB
+    std::atomic<float>* smoothingParam = nullptr;
+    std::atomic<float>* controlIntervalParam = nullptr;
+    std::atomic<float>* autoGainParam = nullptr;
+    juce::StringArray filtersList {"Peak", "Low Pass", "High Pass", "Band Pass", "Notch", "All Pass", "Low Shelf", "High Shelf"};
+    juce::StringArray channelsList {"All (no LFE)", "Front", "Surround", "Height", "LFE"};
+    juce::StringArray routingList {"Stereo", "Left", "Right", "Mid", "Side"};
+    juce::StringArray slopesList {"6 dB/oct", "12 dB/oct", "18 dB/oct", "24 dB/oct", "30 dB/oct", "36 dB/oct", "42 dB/oct", "48 dB/oct",
+                                  "54 dB/oct", "60 dB/oct", "66 dB/oct", "72 dB/oct", "78 dB/oct", "84 dB/oct", "90 dB/oct", "96 dB/oct"};
+    juce::StringArray characteristicsList {"Butterworth", "Linkwitz-Riley", "Bessel"};
+    std::atomic<bool> guiNeedsUpdate {false};
+    juce::Array<juce::RangedAudioParameter*> stateParameters;
+    static constexpr juce::int32 stateMagic = 0x42514550; // "PEQB"
+    static constexpr juce::int32 stateVersion = 2; // 2: MIDI map after the parameters
+    juce::AudioProcessorValueTreeState parameters;
+    CoefficientDesigner designer;
+    MidiControl midiControl;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhaseEQAudioProcessor)
+};
@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurve.h"
+
+//==============================================================================
+void ResponseCurve::prepare (const double* frequencies, int numPoints, double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    auto n = (size_t) juce::jmax (0, numPoints);
+    cosW.resize (n);
+    sinW.resize (n);
+    cos2W.resize (n);
+    sin2W.resize (n);
+    magnitudeDb.assign (n, 0.f);
+    phase.assign (n, 0.f);
+    groupDelayMs.assign (n, 0.f);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto omega = sampleRate > 0.0 ? juce::MathConstants<double>::twoPi * frequencies[i] / sampleRate : 0.0;
+        cosW[i] = std::cos (omega);
+        sinW[i] = std::sin (omega);
+        cos2W[i] = std::cos (2.0 * omega);
+        sin2W[i] = std::sin (2.0 * omega);
+    }
+
+    // everything has to be evaluated again at the new points
+    for (auto& s : sections)
+    {
+        s.active = false;
+        s.magnitudeDb.assign (n, 0.f);
+        s.phase.assign (n, 0.f);
+        s.groupDelayMs.assign (n, 0.f);
+    }
+}
+
+bool ResponseCurve::update (const CascadeSetup& setup)
+{
+    std::array<bool, CascadeSetup::maxSections> active {};
+    for (int i = 0; i < setup.numActive; ++i)
+        active[(size_t) setup.activeSections[(size_t) i]] = true;
+
+    auto changed = setup.linearPhase != linearPhase;
+    linearPhase = setup.linearPhase;
+
+    for (size_t slot = 0; slot < sections.size(); ++slot)
+    {
+        auto& s = sections[slot];
+
+        if (active[slot] == s.active && (! s.active || s.coefficients == setup.sections[slot]))
+            continue;
+
+        s.active = active[slot];
+        s.coefficients = setup.sections[slot];
+        changed = true;
+
+        if (s.active)
+            evaluate (s);
+    }
+
+    if (! changed)
+        return false;
+
+    auto n = magnitudeDb.size();
+    std::fill (magnitudeDb.begin(), magnitudeDb.end(), 0.f);
+    std::fill (phase.begin(), phase.end(), 0.f);
+    std::fill (groupDelayMs.begin(), groupDelayMs.end(), 0.f);
+
+    for (auto& s : sections)
+    {
+        if (! s.active)
+            continue;
+
+        juce::FloatVectorOperations::add (magnitudeDb.data(), s.magnitudeDb.data(), (int) n);
+
+        // the FIR's delay is the same at every frequency, so like its phase it shows as flat zero
+        if (! linearPhase)
+        {
+            juce::FloatVectorOperations::add (phase.data(), s.phase.data(), (int) n);
+            juce::FloatVectorOperations::add (groupDelayMs.data(), s.groupDelayMs.data(), (int) n);
+        }
+    }
+
+    // the sum of the section phases is the phase of the product, up to a multiple of 2 pi
+    for (auto& p : phase)
+        p = std::remainder (p, juce::MathConstants<float>::twoPi);
+
+    return true;
+}
+
+void ResponseCurve::evaluate (Section& section) const noexcept
+{
+    auto& c = section.coefficients;
+    auto n = magnitudeDb.size();
+
+    // terms of |N|^2 and |D|^2 that don't depend on frequency
+    auto num0 = c.b0 * c.b0 + c.b1 * c.b1 + c.b2 * c.b2;
+    auto num1 = 2.0 * (c.b0 * c.b1 + c.b1 * c.b2);
+    auto num2 = 2.0 * c.b0 * c.b2;
+    auto den0 = 1.0 + c.a1 * c.a1 + c.a2 * c.a2;
+    auto den1 = 2.0 * (c.a1 + c.a1 * c.a2);
+    auto den2 = 2.0 * c.a2;
+
+    auto* mag = section.magnitudeDb.data();
+    auto* phs = section.phase.data();
+    auto* delay = section.groupDelayMs.data();
+    auto msPerSample = 1000.0 / sampleRate;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto numerator = num0 + num1 * cosW[i] + num2 * cos2W[i];
+        auto denominator = den0 + den1 * cosW[i] + den2 * cos2W[i];
+        mag[i] = (float) (10.0 * std::log10 (juce::jmax (1.0e-20, numerator) / juce::jmax (1.0e-20, denominator)));
+
+        // arg (N / D) = arg (N * conj (D)), with z^-k = cos kw - j sin kw
+        auto nRe = c.b0 + c.b1 * cosW[i] + c.b2 * cos2W[i];
+        auto nIm = -(c.b1 * sinW[i] + c.b2 * sin2W[i]);
+        auto dRe = 1.0 + c.a1 * cosW[i] + c.a2 * cos2W[i];
+        auto dIm = -(c.a1 * sinW[i] + c.a2 * sin2W[i]);
+        phs[i] = (float) std::atan2 (nIm * dRe - nRe * dIm, nRe * dRe + nIm * dIm);
+
+        // group delay of p (z) is Re (sum k p[k] z^-k / p (z)), i.e. Re (P' conj (P)) / |P|^2
+        auto nDelayRe = c.b1 * cosW[i] + 2.0 * c.b2 * cos2W[i];
+        auto nDelayIm = -(c.b1 * sinW[i] + 2.0 * c.b2 * sin2W[i]);
+        auto dDelayRe = c.a1 * cosW[i] + 2.0 * c.a2 * cos2W[i];
+        auto dDelayIm = -(c.a1 * sinW[i] + 2.0 * c.a2 * sin2W[i]);
+        auto nDelay = (nDelayRe * nRe + nDelayIm * nIm) / juce::jmax (1.0e-20, numerator);
+        auto dDelay = (dDelayRe * dRe + dDelayIm * dIm) / juce::jmax (1.0e-20, denominator);
+        delay[i] = (float) ((nDelay - dDelay) * msPerSample);
+    }
+}
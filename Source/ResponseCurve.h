@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    ResponseCurve.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "FilterCascade.h"
+
+//==============================================================================
+/**
+    Magnitude, phase and group delay of a CascadeSetup at a fixed set of frequencies, kept per
+    section so that a change to one band only re-evaluates that band.
+
+    The per-point sines and cosines are tabulated once in prepare(), which leaves
+    each section's evaluation as plain arithmetic plus one log and one atan2.
+    The group delay comes straight from the coefficients too, not from
+    differences of the phase.
+    Message thread only.
+*/
+class ResponseCurve
+{
+public:
+    ResponseCurve() = default;
+
+    void prepare (const double* frequencies, int numPoints, double sampleRate);
+    double getSampleRate() const noexcept               { return sampleRate; }
+    int getNumPoints() const noexcept                   { return (int) magnitudeDb.size(); }
+
+    /** Recomputes the sections that changed since the last call and returns true
+        if the summed curve is different. */
+    bool update (const CascadeSetup& setup);
+
+    const float* getMagnitudeDb() const noexcept        { return magnitudeDb.data(); }
+    const float* getPhase() const noexcept              { return phase.data(); }
+    const float* getGroupDelayMs() const noexcept       { return groupDelayMs.data(); }
+
+private:
+    struct Section
+    {
+        BiquadCoefficients coefficients;
+        bool active = false;
+        std::vector<float> magnitudeDb, phase, groupDelayMs;
+    };
+
+    void evaluate (Section& section) const noexcept;
+
+    double sampleRate = 0.0;
+    bool linearPhase = false;
+    std::vector<double> cosW, sinW, cos2W, sin2W;
+    std::array<Section, CascadeSetup::maxSections> sections;
+    std::vector<float> magnitudeDb, phase, groupDelayMs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseCurve)
+};
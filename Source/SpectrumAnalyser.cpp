@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+//==============================================================================
+SpectrumAnalyser::SpectrumAnalyser()
+    : fifoBuffer ((size_t) fifoSize, 0.f),
+      history ((size_t) fftSize, 0.f),
+      fftData ((size_t) fftSize * 2, 0.f),
+      levels ((size_t) fftSize / 2 + 1, float (minDb)),
+      peaks ((size_t) fftSize / 2 + 1, float (minDb)),
+      peakAge ((size_t) fftSize / 2 + 1, 0)
+{
+}
+
+template <typename SampleType>
+void SpectrumAnalyser::pushSamples (const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    if (! active.load (std::memory_order_relaxed))
+        return;
+
+    auto numChannels = (int) block.getNumChannels();
+    auto numSamples = (int) block.getNumSamples();
+
+    if (numChannels == 0 || numSamples == 0)
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    // the reader has fallen behind: dropping the block keeps the audio thread's cost fixed
+    if (size1 + size2 < numSamples)
+        return;
+
+    auto gain = 1.f / (float) numChannels;
+    auto mix = [&] (int destStart, int sourceStart, int count)
+    {
+        if (count <= 0)
+            return;
+
+        auto* dest = fifoBuffer.data() + destStart;
+        auto* source = block.getChannelPointer (0) + sourceStart;
+
+        for (int i = 0; i < count; ++i)
+            dest[i] = (float) source[i] * gain;
+
+        for (int ch = 1; ch < numChannels; ++ch)
+        {
+            source = block.getChannelPointer ((size_t) ch) + sourceStart;
+
+            for (int i = 0; i < count; ++i)
+                dest[i] += (float) source[i] * gain;
+        }
+    };
+
+    mix (start1, 0, size1);
+    mix (start2, size1, size2);
+    fifo.finishedWrite (size1 + size2);
+}
+
+template void SpectrumAnalyser::pushSamples (const juce::dsp::AudioBlock<float>&) noexcept;
+template void SpectrumAnalyser::pushSamples (const juce::dsp::AudioBlock<double>&) noexcept;
+
+void SpectrumAnalyser::setActive (bool shouldBeActive)
+{
+    if (shouldBeActive && ! isActive())
+    {
+        // whatever is left over is from before the editor closed
+        fifo.finishedRead (fifo.getNumReady());
+        std::fill (history.begin(), history.end(), 0.f);
+        std::fill (levels.begin(), levels.end(), float (minDb));
+        std::fill (peaks.begin(), peaks.end(), float (minDb));
+        std::fill (peakAge.begin(), peakAge.end(), 0);
+    }
+
+    active = shouldBeActive;
+}
+
+bool SpectrumAnalyser::process()
+{
+    auto numReady = fifo.getNumReady();
+    if (numReady == 0)
+        return false;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numReady, start1, size1, start2, size2);
+
+    auto append = [this] (const float* source, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            history[(size_t) historyPosition] = source[i];
+            historyPosition = (historyPosition + 1) % fftSize;
+        }
+    };
+
+    append (fifoBuffer.data() + start1, size1);
+    append (fifoBuffer.data() + start2, size2);
+    fifo.finishedRead (size1 + size2);
+
+    // oldest sample first
+    std::copy (history.begin() + historyPosition, history.end(), fftData.begin());
+    std::copy (history.begin(), history.begin() + historyPosition, fftData.begin() + (fftSize - historyPosition));
+    std::fill (fftData.begin() + fftSize, fftData.end(), 0.f);
+
+    window.multiplyWithWindowingTable (fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+    // a full scale sine reads 0 dB: the Hann window halves the amplitude and the bins carry N / 2
+    auto scale = 4.f / (float) fftSize;
+
+    for (size_t k = 0; k < levels.size(); ++k)
+    {
+        auto db = juce::Decibels::gainToDecibels (fftData[k] * scale, minDb);
+        levels[k] = smoothing * levels[k] + (1.f - smoothing) * db;
+
+        if (levels[k] >= peaks[k])
+        {
+            peaks[k] = levels[k];
+            peakAge[k] = 0;
+        }
+        else if (++peakAge[k] > peakHoldFrames)
+        {
+            peaks[k] = juce::jmax (levels[k], peaks[k] - peakFallDb);
+        }
+    }
+
+    return true;
+}
+
+float SpectrumAnalyser::interpolate (const std::vector<float>& bins, double frequency) const noexcept
+{
+    auto rate = sampleRate.load();
+    if (rate <= 0.0)
+        return minDb;
+
+    auto position = juce::jlimit (0.0, (double) (bins.size() - 1), frequency * fftSize / rate);
+    auto index = juce::jmin ((size_t) position, bins.size() - 2);
+    auto fraction = (float) (position - (double) index);
+
+    return bins[index] + fraction * (bins[index + 1] - bins[index]);
+}
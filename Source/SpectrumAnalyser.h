@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Spectrum of the signal passing through the processor, for display.
+
+    The audio thread calls pushSamples(), which mixes the block down to mono and
+    copies it into a preallocated juce::AbstractFifo - nothing else. While no
+    editor has called setActive (true) that is a single relaxed load and a return.
+
+    The message thread calls process() from a timer: it drains the FIFO, runs one
+    Hann windowed FFT over the latest fftSize samples and updates the smoothed
+    and peak hold levels read back with getLevelAt() and getPeakAt().
+*/
+class SpectrumAnalyser
+{
+public:
+    SpectrumAnalyser();
+
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr float minDb = -96.f;
+
+    /** Audio thread. */
+    void setSampleRate (double newSampleRate) noexcept  { sampleRate = newSampleRate; }
+    template <typename SampleType>
+    void pushSamples (const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** Message thread. */
+    void setActive (bool shouldBeActive);
+    bool isActive() const noexcept                      { return active.load (std::memory_order_relaxed); }
+
+    /** Message thread: returns true if the levels changed. */
+    bool process();
+
+    float getLevelAt (double frequency) const noexcept  { return interpolate (levels, frequency); }
+    float getPeakAt (double frequency) const noexcept   { return interpolate (peaks, frequency); }
+
+private:
+    float interpolate (const std::vector<float>& bins, double frequency) const noexcept;
+
+    static constexpr int fifoSize = 32768;
+    static constexpr int peakHoldFrames = 60;
+    static constexpr float peakFallDb = 0.5f;
+    static constexpr float smoothing = 0.7f;
+
+    std::atomic<bool> active { false };
+    std::atomic<double> sampleRate { 0.0 };
+
+    juce::AbstractFifo fifo { fifoSize };
+    std::vector<float> fifoBuffer;
+
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false };
+    std::vector<float> history, fftData, levels, peaks;
+    std::vector<int> peakAge;
+    int historyPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyser)
+};
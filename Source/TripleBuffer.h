@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Single producer, single consumer handoff of the latest value of Type.
+
+    The writer fills getWriteBuffer() and calls publish(); the reader calls
+    update() and, if it returns true, reads getReadBuffer(). Both sides only do
+    one atomic exchange, never block and never allocate, so either side can be
+    the audio thread. Intermediate values may be skipped - only the most recent
+    one is guaranteed to arrive.
+*/
+template <typename Type>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    /** Writer side. */
+    Type& getWriteBuffer() noexcept             { return buffers[(size_t) writeIndex]; }
+
+    void publish() noexcept
+    {
+        auto previous = shared.exchange (writeIndex | dirtyBit, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    /** Writes a copy of value and publishes it. */
+    void push (const Type& value) noexcept
+    {
+        getWriteBuffer() = value;
+        publish();
+    }
+
+    /** Reader side. Returns true if a new value was picked up. */
+    bool update() noexcept
+    {
+        if ((shared.load (std::memory_order_relaxed) & dirtyBit) == 0)
+            return false;
+
+        auto previous = shared.exchange (readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const Type& getReadBuffer() const noexcept  { return buffers[(size_t) readIndex]; }
+
+private:
+    static constexpr int indexMask = 3, dirtyBit = 4;
+
+    std::array<Type, 3> buffers {};
+    std::atomic<int> shared { 1 };
+    int writeIndex = 0, readIndex = 2;
+
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.cpp
+
+    Replaces the global operator new and delete of the executable it is linked
+    into, so PerformanceMonitor can count the heap calls made inside a block.
+    Only PhaseEQBench and PhaseEQRender link it, and they define
+    PHASEEQ_COUNT_ALLOCATIONS so the monitor reports the count; the plugin
+    leaves the host's allocator alone.
+
+    Every replaceable form is covered, so no new is paired with a delete that
+    bypasses the count: plain, array, nothrow, sized and, where the language
+    has them, aligned.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PerformanceMonitor.h"
+
+#include <new>
+
+namespace
+{
+    void* allocate (std::size_t size) noexcept
+    {
+        PerformanceMonitor::countHeapCall();
+        return std::malloc (size == 0 ? 1 : size);
+    }
+
+    void release (void* p) noexcept
+    {
+        if (p != nullptr)
+            PerformanceMonitor::countHeapCall();
+
+        std::free (p);
+    }
+
+   #if __cpp_aligned_new
+    /** Over-allocates from malloc and keeps the pointer it returned just below the
+        aligned block, since aligned_alloc isn't available everywhere. */
+    void* allocateAligned (std::size_t size, std::align_val_t alignment) noexcept
+    {
+        PerformanceMonitor::countHeapCall();
+
+        auto align = juce::jmax ((std::size_t) alignment, sizeof (void*));
+        auto* raw = static_cast<char*> (std::malloc (size + align + sizeof (void*)));
+
+        if (raw == nullptr)
+            return nullptr;
+
+        auto* aligned = juce::snapPointerToAlignment (raw + sizeof (void*), align);
+        reinterpret_cast<void**> (aligned)[-1] = raw;
+        return aligned;
+    }
+
+    void releaseAligned (void* p) noexcept
+    {
+        if (p == nullptr)
+            return;
+
+        PerformanceMonitor::countHeapCall();
+        std::free (static_cast<void**> (p)[-1]);
+    }
+   #endif
+}
+
+//==============================================================================
+void* operator new (std::size_t size)
+{
+    if (auto* p = allocate (size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)
+{
+    return operator new (size);
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept       { return allocate (size); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept     { return allocate (size); }
+
+void operator delete (void* p) noexcept                                     { release (p); }
+void operator delete[] (void* p) noexcept                                   { release (p); }
+void operator delete (void* p, std::size_t) noexcept                        { release (p); }
+void operator delete[] (void* p, std::size_t) noexcept                      { release (p); }
+void operator delete (void* p, const std::nothrow_t&) noexcept              { release (p); }
+void operator delete[] (void* p, const std::nothrow_t&) noexcept            { release (p); }
+
+#if __cpp_aligned_new
+void* operator new (std::size_t size, std::align_val_t alignment)
+{
+    if (auto* p = allocateAligned (size, alignment))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment)
+{
+    return operator new (size, alignment);
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept      { return allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept    { return allocateAligned (size, alignment); }
+
+void operator delete (void* p, std::align_val_t) noexcept                                  { releaseAligned (p); }
+void operator delete[] (void* p, std::align_val_t) noexcept                                { releaseAligned (p); }
+void operator delete (void* p, std::size_t, std::align_val_t) noexcept                     { releaseAligned (p); }
+void operator delete[] (void* p, std::size_t, std::align_val_t) noexcept                   { releaseAligned (p); }
+void operator delete (void* p, std::align_val_t, const std::nothrow_t&) noexcept           { releaseAligned (p); }
+void operator delete[] (void* p, std::align_val_t, const std::nothrow_t&) noexcept         { releaseAligned (p); }
+#endif
@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    ResponseValidation.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseValidation.h"
+
+namespace ResponseValidation
+{
+
+namespace
+{
+    constexpr int blockSize = 512;
+
+    void setParameter (PhaseEQAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* param = processor.getParameters().getParameter (id))
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    /** Bins 0 ... size / 2 of a power of two length signal. */
+    std::vector<std::complex<double>> getSpectrum (const std::vector<double>& signal)
+    {
+        juce::dsp::FFT fft (juce::roundToInt (std::log2 ((double) signal.size())));
+        std::vector<float> data (signal.size() * 2, 0.f);
+        std::transform (signal.begin(), signal.end(), data.begin(), [] (double x) { return (float) x; });
+        fft.performRealOnlyForwardTransform (data.data(), true);
+
+        std::vector<std::complex<double>> bins (signal.size() / 2 + 1);
+        for (size_t k = 0; k < bins.size(); ++k)
+            bins[k] = { data[k * 2], data[k * 2 + 1] };
+
+        return bins;
+    }
+
+    /** Runs the same input through every channel from a freshly prepared processor, and
+        returns channel by channel output, counting anything non-finite or denormal. */
+    template <typename SampleType>
+    std::vector<std::vector<double>> render (PhaseEQAudioProcessor& processor, const Case& c,
+                                             const std::vector<double>& input, Result& result)
+    {
+        processor.setProcessingPrecision (std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                   : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (c.rate, blockSize);
+        processor.prepareToPlay (c.rate, blockSize);
+
+        auto length = (int) input.size();
+        std::vector<std::vector<double>> output ((size_t) c.numChannels, std::vector<double> ((size_t) length));
+        juce::AudioBuffer<SampleType> buffer (c.numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::int64 ticks = 0;
+
+        for (int start = 0; start < length; start += blockSize)
+        {
+            for (int ch = 0; ch < c.numChannels; ++ch)
+                for (int n = 0; n < blockSize; ++n)
+                    buffer.setSample (ch, n, (SampleType) input[(size_t) (start + n)]);
+
+            auto before = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midi);
+
+            // the first block also runs the design
+            if (start > 0)
+                ticks += juce::Time::getHighResolutionTicks() - before;
+
+            for (int ch = 0; ch < c.numChannels; ++ch)
+            {
+                for (int n = 0; n < blockSize; ++n)
+                {
+                    auto y = buffer.getSample (ch, n);
+
+                    if (! std::isfinite (y))
+                        ++result.nonFinite;
+                    else if (y != 0 && std::abs (y) < std::numeric_limits<SampleType>::min())
+                        ++result.denormals;
+
+                    output[(size_t) ch][(size_t) (start + n)] = (double) y;
+                }
+            }
+        }
+
+        processor.releaseResources();
+        result.nsPerSample = juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e9 / (double) (length - blockSize);
+        return output;
+    }
+
+    template <typename SampleType>
+    Result validate (PhaseEQAudioProcessor& processor, const Case& c)
+    {
+        using namespace ParameterIDs;
+
+        for (int i = 0; i < numBands; ++i)
+            setParameter (processor, band (enabled, i), i == 0 ? 1.f : 0.f);
+
+        setParameter (processor, band (ParameterIDs::type, 0), (float) c.type);
+        setParameter (processor, band (ParameterIDs::freq, 0), (float) c.freq);
+        setParameter (processor, band (ParameterIDs::q, 0), (float) c.q);
+        setParameter (processor, band (ParameterIDs::gain, 0), (float) c.gain);
+        setParameter (processor, band (dynamic, 0), 0.f);
+        setParameter (processor, smoothing, 0.f);
+        setParameter (processor, phaseMode, 0.f);
+        setParameter (processor, oversampling, 0.f);
+
+        // the reference is the band's design from the values the parameters really hold,
+        // rounded the same way the cascade rounds it, which is not at all near the unit circle
+        auto actual = [&] (const char* id)
+        {
+            auto* param = processor.getParameters().getParameter (band (id, 0));
+            return (double) param->convertFrom0to1 (param->getValue());
+        };
+
+        auto designed = FilterDesign::design (c.type, c.rate, actual (ParameterIDs::freq), actual (ParameterIDs::q), actual (ParameterIDs::gain));
+        auto coefficients = designed;
+
+        if (! FilterCascade<SampleType>::needsDoublePrecision (designed))
+            coefficients = { (double) (SampleType) designed.b0, (double) (SampleType) designed.b1, (double) (SampleType) designed.b2,
+                             (double) (SampleType) designed.a1, (double) (SampleType) designed.a2 };
+
+        // long enough for the sweep, then for the ring to die away before the FFT wraps around
+        auto decay = FilterDesign::getDecaySamples (coefficients, 140.0, c.rate * 8.0);
+        auto length = juce::jmin (1 << 21, juce::nextPowerOfTwo ((int) (2.0 * juce::jmax (decay, c.rate * 0.5))));
+        auto numBins = (size_t) (length / 2 + 1);
+
+        auto peak = 0.0;
+        for (size_t k = 0; k < numBins; ++k)
+            peak = juce::jmax (peak, FilterDesign::getMagnitude (coefficients, c.rate * (double) k / length, c.rate));
+
+        Result result;
+        std::vector<double> impulse ((size_t) length, 0.0), sweep ((size_t) length, 0.0);
+        impulse[0] = 1.0;
+
+        // exponential sweep from 10 Hz to just below Nyquist over the first half
+        auto phase = 0.0;
+        for (int n = 0; n < length / 2; ++n)
+        {
+            sweep[(size_t) n] = 0.5 * std::sin (phase);
+            phase += juce::MathConstants<double>::twoPi * 10.0 * std::pow (0.49 * c.rate / 10.0, (double) n / (length / 2)) / c.rate;
+        }
+
+        auto impulseOut = render<SampleType> (processor, c, impulse, result);
+        auto timing = result.nsPerSample;
+        auto sweepOut = render<SampleType> (processor, c, sweep, result);
+        result.nsPerSample = 0.5 * (timing + result.nsPerSample);
+
+        auto sweepIn = getSpectrum (sweep);
+        auto irError = 0.0;
+
+        for (auto& channel : impulseOut)
+        {
+            // a stable band has rung down long before the end of the buffer
+            auto tail = 0.0, irPeak = 0.0;
+            for (size_t n = 0; n < channel.size(); ++n)
+            {
+                irPeak = juce::jmax (irPeak, std::abs (channel[n]));
+                if (n >= channel.size() * 7 / 8)
+                    tail = juce::jmax (tail, std::abs (channel[n]));
+            }
+
+            result.stable = result.stable && tail <= irPeak * 1.0e-5;
+
+            auto measured = getSpectrum (channel);
+            for (size_t k = 0; k < numBins; ++k)
+                irError = juce::jmax (irError, std::abs (measured[k] - FilterDesign::getResponse (coefficients, c.rate * (double) k / length, c.rate)));
+        }
+
+        result.irErrorDb = juce::Decibels::gainToDecibels (irError / peak, -400.0);
+
+        for (auto& channel : sweepOut)
+        {
+            auto measured = getSpectrum (channel);
+
+            for (size_t k = 1; k < numBins; ++k)
+            {
+                auto frequency = c.rate * (double) k / length;
+                auto expected = FilterDesign::getMagnitude (coefficients, frequency, c.rate);
+
+                // deep notches and the sweep's own edges say nothing about the filter
+                if (frequency < 20.0 || frequency > 0.45 * c.rate || expected < peak * 0.01)
+                    continue;
+
+                auto deviation = juce::Decibels::gainToDecibels (std::abs (measured[k] / sweepIn[k]) / expected, -400.0);
+                result.sweepErrorDb = juce::jmax (result.sweepErrorDb, std::abs (deviation));
+            }
+        }
+
+        return result;
+    }
+}
+
+//==============================================================================
+juce::String Case::getKey() const
+{
+    return juce::StringArray { juce::String (type), juce::String (rate), juce::String (numChannels),
+                               juce::String (freq), juce::String (q), juce::String (gain) }.joinIntoString (",");
+}
+
+Case makeCase (int type, double rate, int numChannels, int corner)
+{
+    const double freqs[] = { 30.0, 1000.0, 20000.0 }, qs[] = { 0.1, 18.0 }, gains[] = { -10.0, 10.0 };
+    jassert (juce::isPositiveAndBelow (corner, numCorners));
+
+    return { type, numChannels, rate, freqs[corner / 4], qs[(corner / 2) % 2], gains[corner % 2] };
+}
+
+bool setLayout (PhaseEQAudioProcessor& processor, int numChannels)
+{
+    // only the main buses change; the sidechain stays as it is (disconnected)
+    auto layout = processor.getBusesLayout();
+    layout.getChannelSet (true, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+    layout.getChannelSet (false, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+    if (! processor.setBusesLayout (layout))
+        return false;
+
+    processor.setNonRealtime (true);
+    return true;
+}
+
+Result validate (PhaseEQAudioProcessor& processor, const Case& c, bool doublePrecision)
+{
+    return doublePrecision ? validate<double> (processor, c)
+                           : validate<float>  (processor, c);
+}
+
+juce::StringArray getFailures (const Result& result, const Tolerances& tolerances)
+{
+    juce::StringArray failures;
+    if (result.irErrorDb > tolerances.irErrorDb)        failures.add ("ir");
+    if (result.sweepErrorDb > tolerances.sweepErrorDb)  failures.add ("sweep");
+    if (result.nonFinite > 0)                           failures.add ("nan");
+    if (result.denormals > 0)                           failures.add ("denormal");
+    if (! result.stable)                                failures.add ("unstable");
+    return failures;
+}
+
+}
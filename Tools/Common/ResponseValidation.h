@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    ResponseValidation.h
+
+    Renders an impulse and a sweep through one band of the processor and
+    checks them against the response of the band's own coefficients. Shared
+    by PhaseEQBench --validate, which adds baselines and timing, and by the
+    ResponseValidation unit test in PhaseEQTests.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+namespace ResponseValidation
+{
+    /** One band at one setting. */
+    struct Case
+    {
+        int type = 0, numChannels = 1;
+        double rate = 0, freq = 0, q = 0, gain = 0;
+
+        /** The leading columns of PhaseEQBench's CSV output, which is also how --baseline rows are matched. */
+        juce::String getKey() const;
+    };
+
+    struct Result
+    {
+        double irErrorDb = -400.0;  // complex error of the impulse response's spectrum, relative to its peak
+        double sweepErrorDb = 0.0;  // largest magnitude deviation of output / input over the sweep
+        int nonFinite = 0, denormals = 0;
+        bool stable = true;
+        double nsPerSample = 0.0;
+    };
+
+    /** How close a healthy build gets. Float sections with a pole near the unit circle
+        run in double (FilterCascade::needsDoublePrecision), so float is limited by the
+        rounding of the other sections' coefficients, to around -70 dB and 0.05 dB at
+        worst; double mostly by the float FFT used for the comparison. */
+    struct Tolerances
+    {
+        double irErrorDb, sweepErrorDb;
+    };
+
+    constexpr Tolerances floatTolerances  { -60.0, 0.1 };
+    constexpr Tolerances doubleTolerances { -90.0, 0.01 };
+
+    /** Every type is checked at each combination of the extremes of FREQ, Q and GAIN. */
+    constexpr int numCorners = 3 * 2 * 2;
+    Case makeCase (int type, double rate, int numChannels, int corner);
+
+    /** Puts numChannels on the main buses, and the processor offline so every parameter
+        change is designed before the next block. False if the layout isn't supported. */
+    bool setLayout (PhaseEQAudioProcessor& processor, int numChannels);
+
+    /** Renders the case through a freshly prepared processor in the given precision. */
+    Result validate (PhaseEQAudioProcessor& processor, const Case& c, bool doublePrecision);
+
+    /** Which of "ir", "sweep", "nan", "denormal" and "unstable" the result fails. */
+    juce::StringArray getFailures (const Result& result, const Tolerances& tolerances);
+}
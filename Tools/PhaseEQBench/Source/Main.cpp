@@ -0,0 +1,560 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Throughput benchmark for PhaseEQAudioProcessor::processBlock, and for
+    saving and restoring its state. With --validate, a regression check of
+    the rendered responses instead.
+
+    PhaseEQBench [options]
+
+      --rates <list>      sample rates (default 44100,48000,96000,192000)
+      --channels <list>   channel counts (default 1,2)
+      --blocks <list>     block sizes (default 16,32,64,...,4096)
+      --types <list>      filtersList indices to run (default all eight)
+      --bands <n>         enabled bands per run (default all)
+      --seconds <s>       audio rendered per configuration (default 2)
+      --double            process in double precision
+      --csv               machine readable output
+      --stats             after each run, the processor's own PerformanceMonitor
+                          report: load percentiles, deadline misses, redesigns and
+                          heap calls inside processBlock
+
+      --state             time getStateInformation/setStateInformation instead,
+                          binary against the old XML format
+      --instances <list>  instance counts for --state (default 1,100,1000)
+
+      --design            designs per second of FilterDesign::design against
+                          FastFilterDesign, with the largest coefficient error,
+                          for random bands of --types at each of --rates, from
+                          10 Hz up to 0.499 of the rate
+
+      --validate          renders an impulse and a sweep through one band of each of
+                          --types at each of --rates and --channels, at the extremes of
+                          FREQ, Q and GAIN, and checks them against the response of
+                          the band's own coefficients (rounded to the precision the
+                          cascade runs them in), plus NaN/inf, denormal output and
+                          stability. Exits with 1 if any case fails. PhaseEQTests
+                          runs the same cases as its ResponseValidation test.
+      --baseline <file>   --validate --csv output of an earlier run: a case then also
+                          fails if its errors grew by more than 1 dB, or it got more
+                          than --cpu-margin slower
+      --cpu-margin <pct>  allowed slowdown against --baseline (default 25)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/FastFilterDesign.h"
+#include "../../Common/ResponseValidation.h"
+
+//==============================================================================
+namespace
+{
+    struct Options
+    {
+        juce::Array<double> rates { 44100.0, 48000.0, 96000.0, 192000.0 };
+        juce::Array<int> channels { 1, 2 };
+        juce::Array<int> blocks { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<int> types { 0, 1, 2, 3, 4, 5, 6, 7 };
+        int bands = ParameterIDs::numBands;
+        double seconds = 2.0;
+        juce::Array<int> instances { 1, 100, 1000 };
+        bool csv = false;
+        bool stats = false;
+        bool doublePrecision = false;
+        bool state = false;
+        bool design = false;
+        bool validate = false;
+        juce::File baseline;
+        double cpuMargin = 0.25;
+    };
+
+    template <typename Type>
+    juce::Array<Type> parseList (const juce::String& text)
+    {
+        juce::Array<Type> result;
+        for (auto& item : juce::StringArray::fromTokens (text, ",", {}))
+            result.add ((Type) item.getDoubleValue());
+        return result;
+    }
+
+    juce::Result parseArguments (const juce::StringArray& args, Options& options)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            auto arg = args[i];
+            auto hasValue = i + 1 < args.size();
+
+            if      (arg == "--rates"    && hasValue)  options.rates    = parseList<double> (args[++i]);
+            else if (arg == "--channels" && hasValue)  options.channels = parseList<int> (args[++i]);
+            else if (arg == "--blocks"   && hasValue)  options.blocks   = parseList<int> (args[++i]);
+            else if (arg == "--types"    && hasValue)  options.types    = parseList<int> (args[++i]);
+            else if (arg == "--bands"    && hasValue)  options.bands    = juce::jlimit (0, ParameterIDs::numBands, args[++i].getIntValue());
+            else if (arg == "--seconds"  && hasValue)  options.seconds  = juce::jmax (0.01, args[++i].getDoubleValue());
+            else if (arg == "--csv")                   options.csv = true;
+            else if (arg == "--stats")                 options.stats = true;
+            else if (arg == "--instances" && hasValue) options.instances = parseList<int> (args[++i]);
+            else if (arg == "--double")                options.doublePrecision = true;
+            else if (arg == "--state")                 options.state = true;
+            else if (arg == "--design")                options.design = true;
+            else if (arg == "--validate")              options.validate = true;
+            else if (arg == "--cpu-margin" && hasValue) options.cpuMargin = juce::jmax (0.0, args[++i].getDoubleValue() / 100.0);
+            else if (arg == "--baseline" && hasValue)
+            {
+                options.baseline = juce::File::getCurrentWorkingDirectory().getChildFile (args[++i]);
+                if (! options.baseline.existsAsFile())
+                    return juce::Result::fail ("No such file " + options.baseline.getFullPathName());
+            }
+            else return juce::Result::fail ("Unknown option " + arg);
+        }
+
+        return juce::Result::ok();
+    }
+
+    void setParameter (PhaseEQAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* param = processor.getParameters().getParameter (id))
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    /** Spreads the enabled bands over the spectrum, all of the same type. */
+    void configure (PhaseEQAudioProcessor& processor, int type, int numEnabled)
+    {
+        using namespace ParameterIDs;
+
+        for (int i = 0; i < numBands; ++i)
+        {
+            auto freq = 100.f * std::pow (100.f, (float) i / (float) juce::jmax (1, numBands - 1));
+
+            setParameter (processor, band (enabled, i), i < numEnabled ? 1.f : 0.f);
+            setParameter (processor, band (ParameterIDs::type, i), (float) type);
+            setParameter (processor, band (ParameterIDs::freq, i), freq);
+            setParameter (processor, band (gain, i), 6.f);
+            setParameter (processor, band (q, i), 1.f);
+        }
+    }
+
+    struct Result
+    {
+        double nsPerSample = 0, p50 = 0, p99 = 0, max = 0, budget = 0;
+        juce::String stats;
+    };
+
+    template <typename SampleType>
+    Result run (PhaseEQAudioProcessor& processor, double sampleRate, int numChannels, int blockSize, double seconds)
+    {
+        processor.setProcessingPrecision (std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                   : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<SampleType> noise (numChannels, blockSize), buffer (numChannels, blockSize);
+        juce::Random random (1234);
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int n = 0; n < blockSize; ++n)
+                noise.setSample (ch, n, (SampleType) (random.nextFloat() * 2.f - 1.f));
+
+        juce::MidiBuffer midi;
+        auto numCalls = juce::jmax (64, (int) (seconds * sampleRate / blockSize));
+        std::vector<juce::int64> ticks ((size_t) numCalls);
+
+        // warm up caches and let any pending design land
+        for (int i = 0; i < 16; ++i)
+        {
+            buffer.makeCopyOf (noise, true);
+            processor.processBlock (buffer, midi);
+        }
+
+        auto& monitor = processor.getPerformanceMonitor();
+        monitor.reset();
+
+        for (auto& t : ticks)
+        {
+            buffer.makeCopyOf (noise, true);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock (buffer, midi);
+            t = juce::Time::getHighResolutionTicks() - start;
+        }
+
+        // this thread played the audio thread, so it can hand over the last counters itself
+        monitor.publish();
+        monitor.update();
+        auto stats = monitor.getSnapshot().toString();
+
+        processor.releaseResources();
+
+        auto toMicroseconds = [] (juce::int64 t) { return juce::Time::highResolutionTicksToSeconds (t) * 1.0e6; };
+        auto total = std::accumulate (ticks.begin(), ticks.end(), (juce::int64) 0);
+        std::sort (ticks.begin(), ticks.end());
+
+        Result result;
+        result.nsPerSample = toMicroseconds (total) * 1000.0 / ((double) numCalls * blockSize);
+        result.p50 = toMicroseconds (ticks[ticks.size() / 2]);
+        result.p99 = toMicroseconds (ticks[(ticks.size() * 99) / 100]);
+        result.max = toMicroseconds (ticks.back());
+        result.budget = 1.0e6 * blockSize / sampleRate;
+        result.stats = stats;
+        return result;
+    }
+
+    //==============================================================================
+    /** Exact and fast designs of the same random bands: throughput and agreement. */
+    void runDesignBenchmark (const Options& options)
+    {
+        constexpr int batchSize = 1024;
+
+        if (options.csv)
+            std::cout << "rate,exact_per_s,fast_per_s,fast_gain_per_s,max_error" << std::endl;
+        else
+            std::cout << "    rate    exact/s     fast/s  fast gain/s  max error" << std::endl;
+
+        for (auto rate : options.rates)
+        {
+            juce::Random random (1234);
+            std::vector<int> types (batchSize);
+            std::vector<double> freqs (batchSize), qs (batchSize), gains (batchSize);
+            std::vector<FilterDesign::GainPrototype> prototypes (batchSize);
+            std::vector<BiquadCoefficients> exact (batchSize), fast (batchSize);
+
+            for (int i = 0; i < batchSize; ++i)
+            {
+                types[(size_t) i] = options.types[i % options.types.size()];
+                freqs[(size_t) i] = 10.0 * std::pow (0.499 * rate / 10.0, random.nextDouble());
+                qs[(size_t) i] = 0.1 * std::pow (180.0, random.nextDouble());
+                gains[(size_t) i] = random.nextDouble() * 96.0 - 48.0;
+                prototypes[(size_t) i] = FilterDesign::makeGainPrototype (FilterDesign::peak, rate, freqs[(size_t) i], qs[(size_t) i]);
+            }
+
+            // and every type at both ends of the range, where the designs clamp
+            for (size_t i = 0; i < options.types.size() * 2; ++i)
+            {
+                types[i] = options.types[i / 2];
+                freqs[i] = i % 2 == 0 ? 10.0 : 0.499 * rate;
+            }
+
+            // designs per second of whatever step does to the whole batch, run for the requested time
+            auto designsPerSecond = [&] (std::function<void()> step)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+                juce::int64 numDesigns = 0;
+                double elapsed = 0.0;
+
+                while (elapsed < options.seconds)
+                {
+                    step();
+                    numDesigns += batchSize;
+                    elapsed = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+                }
+
+                return (double) numDesigns / elapsed;
+            };
+
+            auto exactRate = designsPerSecond ([&]
+            {
+                for (size_t i = 0; i < (size_t) batchSize; ++i)
+                    exact[i] = FilterDesign::design (types[i], rate, freqs[i], qs[i], gains[i]);
+            });
+
+            auto fastRate = designsPerSecond ([&]
+            {
+                FastFilterDesign::design (types.data(), rate, freqs.data(), qs.data(), gains.data(), fast.data(), batchSize);
+            });
+
+            // error against the exact designs, relative to each section's largest coefficient
+            double maxError = 0.0;
+            for (size_t i = 0; i < (size_t) batchSize; ++i)
+            {
+                auto& e = exact[i];
+                auto& f = fast[i];
+                auto scale = juce::jmax (1.0, std::abs (e.b0), std::abs (e.b1), std::abs (e.b2));
+                auto error = juce::jmax (juce::jmax (std::abs (e.b0 - f.b0), std::abs (e.b1 - f.b1), std::abs (e.b2 - f.b2)),
+                                         std::abs (e.a1 - f.a1), std::abs (e.a2 - f.a2));
+                maxError = juce::jmax (maxError, error / scale);
+            }
+
+            auto gainRate = designsPerSecond ([&]
+            {
+                FastFilterDesign::designWithGain (prototypes.data(), gains.data(), fast.data(), batchSize);
+            });
+
+            if (options.csv)
+            {
+                std::cout << rate << "," << exactRate << "," << fastRate << "," << gainRate << "," << maxError << std::endl;
+            }
+            else
+            {
+                std::cout << juce::String ((int) rate).paddedLeft (' ', 8)
+                          << juce::String (exactRate / 1.0e6, 2).paddedLeft (' ', 10) << "M"
+                          << juce::String (fastRate / 1.0e6, 2).paddedLeft (' ', 10) << "M"
+                          << juce::String (gainRate / 1.0e6, 2).paddedLeft (' ', 12) << "M"
+                          << juce::String (maxError, 2, true).paddedLeft (' ', 11) << std::endl;
+            }
+        }
+    }
+
+    //==============================================================================
+    std::map<juce::String, ResponseValidation::Result> loadBaseline (const juce::File& file)
+    {
+        std::map<juce::String, ResponseValidation::Result> baseline;
+        juce::StringArray lines;
+        file.readLines (lines);
+
+        for (auto& line : lines)
+        {
+            auto tokens = juce::StringArray::fromTokens (line, ",", {});
+            if (tokens.size() < 12 || tokens[0] == "type")
+                continue;
+
+            ResponseValidation::Result r;
+            r.irErrorDb = tokens[6].getDoubleValue();
+            r.sweepErrorDb = tokens[7].getDoubleValue();
+            r.nsPerSample = tokens[11].getDoubleValue();
+
+            tokens.removeRange (6, tokens.size() - 6);
+            baseline[tokens.joinIntoString (",")] = r;
+        }
+
+        return baseline;
+    }
+
+    /** Every type at every rate and channel count, at the corners of the FREQ, Q and GAIN ranges. */
+    bool runValidation (const Options& options)
+    {
+        auto tolerances = options.doublePrecision ? ResponseValidation::doubleTolerances : ResponseValidation::floatTolerances;
+        auto baseline = options.baseline.existsAsFile() ? loadBaseline (options.baseline) : std::map<juce::String, ResponseValidation::Result>();
+
+        PhaseEQAudioProcessor processor;
+        auto filterNames = processor.getFiltersList();
+        int numCases = 0, numFailed = 0;
+
+        if (options.csv)
+            std::cout << "type,rate,channels,freq,q,gain,ir_error_db,sweep_error_db,non_finite,denormals,stable,ns_per_sample,result" << std::endl;
+        else
+            std::cout << "type        rate  ch     freq     q   gain  ir err dB  sweep dB  nan  denorm  ns/sample  result" << std::endl;
+
+        for (auto type : options.types)
+        {
+            for (auto rate : options.rates)
+            {
+                for (auto numChannels : options.channels)
+                {
+                    if (! ResponseValidation::setLayout (processor, numChannels))
+                    {
+                        std::cerr << "skipping unsupported " << numChannels << " channel layout" << std::endl;
+                        continue;
+                    }
+
+                    for (int corner = 0; corner < ResponseValidation::numCorners; ++corner)
+                    {
+                        auto c = ResponseValidation::makeCase (type, rate, numChannels, corner);
+                        auto r = ResponseValidation::validate (processor, c, options.doublePrecision);
+                        auto failures = ResponseValidation::getFailures (r, tolerances);
+
+                        // against a baseline, only getting worse counts: known precision limits pass if they held
+                        auto previous = baseline.find (c.getKey());
+                        if (previous != baseline.end())
+                        {
+                            auto& p = previous->second;
+
+                            if (r.irErrorDb <= p.irErrorDb + 1.0)
+                                failures.removeString ("ir");
+                            if (r.sweepErrorDb <= p.sweepErrorDb * juce::Decibels::decibelsToGain (1.0))
+                                failures.removeString ("sweep");
+                            if (r.nsPerSample > p.nsPerSample * (1.0 + options.cpuMargin))
+                                failures.add ("cpu");
+                        }
+
+                        auto verdict = failures.isEmpty() ? juce::String ("ok") : failures.joinIntoString ("+");
+                        ++numCases;
+                        numFailed += failures.isEmpty() ? 0 : 1;
+
+                        if (options.csv)
+                        {
+                            std::cout << c.getKey() << "," << r.irErrorDb << "," << r.sweepErrorDb << "," << r.nonFinite << ","
+                                      << r.denormals << "," << (r.stable ? 1 : 0) << "," << r.nsPerSample << "," << verdict << std::endl;
+                        }
+                        else
+                        {
+                            std::cout << filterNames[type].paddedRight (' ', 10)
+                                      << juce::String ((int) rate).paddedLeft (' ', 7)
+                                      << juce::String (numChannels).paddedLeft (' ', 4)
+                                      << juce::String ((int) c.freq).paddedLeft (' ', 9)
+                                      << juce::String (c.q, 1).paddedLeft (' ', 6)
+                                      << juce::String (c.gain, 0).paddedLeft (' ', 7)
+                                      << juce::String (r.irErrorDb, 1).paddedLeft (' ', 11)
+                                      << juce::String (r.sweepErrorDb, 4).paddedLeft (' ', 10)
+                                      << juce::String (r.nonFinite).paddedLeft (' ', 5)
+                                      << juce::String (r.denormals).paddedLeft (' ', 8)
+                                      << juce::String (r.nsPerSample, 2).paddedLeft (' ', 11)
+                                      << "  " << verdict << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+
+        std::cerr << numFailed << " of " << numCases << " cases failed" << std::endl;
+        return numFailed == 0;
+    }
+
+    //==============================================================================
+    /** Session load and autosave: every instance saved, then restored, in both formats. */
+    void runStateBenchmark (const Options& options)
+    {
+        if (options.csv)
+            std::cout << "instances,binary_bytes,xml_bytes,binary_save_ms,xml_save_ms,binary_load_ms,xml_load_ms" << std::endl;
+        else
+            std::cout << "instances  binary B   xml B  binary save ms  xml save ms  binary load ms  xml load ms" << std::endl;
+
+        for (auto numInstances : options.instances)
+        {
+            juce::OwnedArray<PhaseEQAudioProcessor> processors;
+            for (int i = 0; i < numInstances; ++i)
+                configure (*processors.add (new PhaseEQAudioProcessor()), i % 8, options.bands);
+
+            std::vector<juce::MemoryBlock> binary ((size_t) numInstances), xml ((size_t) numInstances);
+
+            auto timeMs = [numInstances] (std::function<void (int)> step)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+                for (int i = 0; i < numInstances; ++i)
+                    step (i);
+                return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start) * 1000.0;
+            };
+
+            auto binarySave = timeMs ([&] (int i) { processors[i]->getStateInformation (binary[(size_t) i]); });
+
+            // what getStateInformation did before the binary format
+            auto xmlSave = timeMs ([&] (int i)
+            {
+                auto state = processors[i]->getParameters().copyState();
+                std::unique_ptr<juce::XmlElement> element (state.createXml());
+                juce::AudioProcessor::copyXmlToBinary (*element, xml[(size_t) i]);
+            });
+
+            auto binaryLoad = timeMs ([&] (int i) { processors[i]->setStateInformation (binary[(size_t) i].getData(), (int) binary[(size_t) i].getSize()); });
+            auto xmlLoad = timeMs ([&] (int i) { processors[i]->setStateInformation (xml[(size_t) i].getData(), (int) xml[(size_t) i].getSize()); });
+
+            auto binaryBytes = (int) binary.front().getSize();
+            auto xmlBytes = (int) xml.front().getSize();
+
+            if (options.csv)
+            {
+                std::cout << numInstances << "," << binaryBytes << "," << xmlBytes << "," << binarySave << ","
+                          << xmlSave << "," << binaryLoad << "," << xmlLoad << std::endl;
+            }
+            else
+            {
+                std::cout << juce::String (numInstances).paddedLeft (' ', 9)
+                          << juce::String (binaryBytes).paddedLeft (' ', 10)
+                          << juce::String (xmlBytes).paddedLeft (' ', 8)
+                          << juce::String (binarySave, 2).paddedLeft (' ', 16)
+                          << juce::String (xmlSave, 2).paddedLeft (' ', 13)
+                          << juce::String (binaryLoad, 2).paddedLeft (' ', 16)
+                          << juce::String (xmlLoad, 2).paddedLeft (' ', 13) << std::endl;
+            }
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    Options options;
+    auto parsed = parseArguments (args, options);
+
+    if (parsed.failed())
+    {
+        std::cerr << parsed.getErrorMessage() << std::endl
+                  << "usage: PhaseEQBench [--rates list] [--channels list] [--blocks list] [--types list] [--bands n] [--seconds s] [--double] [--csv] [--stats]" << std::endl
+                  << "       PhaseEQBench --state [--instances list] [--bands n] [--csv]" << std::endl
+                  << "       PhaseEQBench --design [--rates list] [--types list] [--seconds s] [--csv]" << std::endl
+                  << "       PhaseEQBench --validate [--rates list] [--channels list] [--types list] [--double] [--baseline file] [--cpu-margin pct] [--csv]" << std::endl;
+        return 1;
+    }
+
+    if (options.validate)
+        return runValidation (options) ? 0 : 1;
+
+    if (options.design)
+    {
+        runDesignBenchmark (options);
+        return 0;
+    }
+
+    if (options.state)
+    {
+        runStateBenchmark (options);
+        return 0;
+    }
+
+    PhaseEQAudioProcessor processor;
+    auto filterNames = processor.getFiltersList();
+
+    if (options.csv)
+        std::cout << "type,rate,channels,block,ns_per_sample,p50_us,p99_us,max_us,budget_us" << std::endl;
+    else
+        std::cout << "type        rate  ch  block  ns/sample    p50 us    p99 us    max us  budget us" << std::endl;
+
+    for (auto type : options.types)
+    {
+        configure (processor, type, options.bands);
+
+        for (auto rate : options.rates)
+        {
+            for (auto numChannels : options.channels)
+            {
+                // only the main buses change; the sidechain stays as it is (disconnected)
+                auto layout = processor.getBusesLayout();
+                layout.getChannelSet (true, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+                layout.getChannelSet (false, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+                if (! processor.setBusesLayout (layout))
+                {
+                    std::cerr << "skipping unsupported " << numChannels << " channel layout" << std::endl;
+                    continue;
+                }
+
+                for (auto blockSize : options.blocks)
+                {
+                    auto r = options.doublePrecision ? run<double> (processor, rate, numChannels, blockSize, options.seconds)
+                                                     : run<float>  (processor, rate, numChannels, blockSize, options.seconds);
+                    auto name = filterNames[type];
+
+                    if (options.csv)
+                    {
+                        std::cout << name << "," << rate << "," << numChannels << "," << blockSize << ","
+                                  << r.nsPerSample << "," << r.p50 << "," << r.p99 << "," << r.max << "," << r.budget << std::endl;
+                    }
+                    else
+                    {
+                        std::cout << name.paddedRight (' ', 10)
+                                  << juce::String ((int) rate).paddedLeft (' ', 7)
+                                  << juce::String (numChannels).paddedLeft (' ', 4)
+                                  << juce::String (blockSize).paddedLeft (' ', 7)
+                                  << juce::String (r.nsPerSample, 2).paddedLeft (' ', 11)
+                                  << juce::String (r.p50, 2).paddedLeft (' ', 10)
+                                  << juce::String (r.p99, 2).paddedLeft (' ', 10)
+                                  << juce::String (r.max, 2).paddedLeft (' ', 10)
+                                  << juce::String (r.budget, 1).paddedLeft (' ', 11) << std::endl;
+                    }
+
+                    if (options.stats && ! options.csv)
+                        std::cout << "    " << r.stats << std::endl;
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,402 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Offline batch renderer: runs audio files through PhaseEQAudioProcessor
+    without a host.
+
+    PhaseEQRender [options] <input files...>
+
+      --output <dir>        where to write results (default: next to the input, "-eq" suffix)
+      --state <file>        state to load; either the blob written by getStateInformation
+                            or the same XML as plain text
+      --param <ID>=<value>  set a parameter in real units, e.g. --param FREQ_1=250 (repeatable)
+      --match <file>        fit the bands to make each input sound like this reference;
+                            replaces whatever --state and --param set for the bands
+      --format <wav|flac>   output format (default: same as the input)
+      --block-size <n>      samples per processBlock call (default 1024)
+      --jobs <n>            files rendered concurrently (default: number of cores)
+      --tail                append the filter tail after the end of the input
+      --stats               print each file's PerformanceMonitor report: load against
+                            real time, redesigns and heap calls inside processBlock
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+#include "../../../Source/MatchEQ.h"
+
+//==============================================================================
+namespace
+{
+    juce::CriticalSection logLock;
+
+    void printLine (const juce::String& message)
+    {
+        const juce::ScopedLock sl (logLock);
+        std::cout << message << std::endl;
+    }
+
+    struct Options
+    {
+        juce::Array<juce::File> inputs;
+        juce::File outputDir;
+        juce::MemoryBlock state;
+        juce::StringPairArray params;
+        juce::File matchReference;
+        MatchEQ::Spectrum matchSpectrum;
+        juce::String format;
+        int blockSize = 1024;
+        int jobs = juce::SystemStats::getNumCpus();
+        bool appendTail = false;
+        bool printStats = false;
+    };
+
+    bool loadState (const juce::File& file, juce::MemoryBlock& dest)
+    {
+        if (! file.loadFileAsData (dest))
+            return false;
+
+        // plain XML is wrapped the same way getStateInformation does it
+        if (dest.getSize() > 0 && static_cast<const char*> (dest.getData())[0] == '<')
+        {
+            auto xml = juce::parseXML (dest.toString());
+            if (xml == nullptr)
+                return false;
+
+            dest.reset();
+            juce::AudioProcessor::copyXmlToBinary (*xml, dest);
+        }
+
+        return true;
+    }
+
+    juce::Result parseArguments (const juce::StringArray& args, Options& options)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            auto arg = args[i];
+            auto next = [&] { return args[++i]; };
+            auto hasValue = i + 1 < args.size();
+
+            if (arg == "--output" && hasValue)
+            {
+                options.outputDir = juce::File::getCurrentWorkingDirectory().getChildFile (next());
+            }
+            else if (arg == "--state" && hasValue)
+            {
+                auto file = juce::File::getCurrentWorkingDirectory().getChildFile (next());
+                if (! loadState (file, options.state))
+                    return juce::Result::fail ("Couldn't read state from " + file.getFullPathName());
+            }
+            else if (arg == "--param" && hasValue)
+            {
+                auto pair = next();
+                if (! pair.containsChar ('='))
+                    return juce::Result::fail ("Expected --param ID=value, got " + pair);
+
+                options.params.set (pair.upToFirstOccurrenceOf ("=", false, false).trim(),
+                                    pair.fromFirstOccurrenceOf ("=", false, false).trim());
+            }
+            else if (arg == "--match" && hasValue)
+            {
+                options.matchReference = juce::File::getCurrentWorkingDirectory().getChildFile (next());
+                if (! options.matchReference.existsAsFile())
+                    return juce::Result::fail ("No such file " + options.matchReference.getFullPathName());
+            }
+            else if (arg == "--format" && hasValue)
+            {
+                options.format = next().trimCharactersAtStart (".").toLowerCase();
+            }
+            else if (arg == "--block-size" && hasValue)
+            {
+                options.blockSize = juce::jlimit (16, 65536, next().getIntValue());
+            }
+            else if (arg == "--jobs" && hasValue)
+            {
+                options.jobs = juce::jmax (1, next().getIntValue());
+            }
+            else if (arg == "--tail")
+            {
+                options.appendTail = true;
+            }
+            else if (arg == "--stats")
+            {
+                options.printStats = true;
+            }
+            else if (arg.startsWith ("-"))
+            {
+                return juce::Result::fail ("Unknown option " + arg);
+            }
+            else
+            {
+                auto file = juce::File::getCurrentWorkingDirectory().getChildFile (arg);
+                if (! file.existsAsFile())
+                    return juce::Result::fail ("No such file " + arg);
+
+                options.inputs.add (file);
+            }
+        }
+
+        if (options.inputs.isEmpty())
+            return juce::Result::fail ("No input files");
+
+        return juce::Result::ok();
+    }
+
+    juce::Result applyOptions (PhaseEQAudioProcessor& processor, const Options& options)
+    {
+        if (options.state.getSize() > 0)
+            processor.setStateInformation (options.state.getData(), (int) options.state.getSize());
+
+        for (auto& id : options.params.getAllKeys())
+        {
+            auto* param = processor.getParameters().getParameter (id);
+            if (param == nullptr)
+                return juce::Result::fail ("Unknown parameter " + id);
+
+            param->setValueNotifyingHost (param->convertTo0to1 (options.params[id].getFloatValue()));
+        }
+
+        return juce::Result::ok();
+    }
+
+    //==============================================================================
+    /** Renders files one after another with its own processor instance. */
+    class RenderWorker  : public juce::Thread
+    {
+    public:
+        RenderWorker (const Options& o, std::atomic<int>& next, std::atomic<int>& failures)
+            : juce::Thread ("PhaseEQ render"), options (o), nextFile (next), numFailures (failures)
+        {
+            formatManager.registerBasicFormats();
+        }
+
+        juce::Result prepare()
+        {
+            return applyOptions (processor, options);
+        }
+
+        void run() override
+        {
+            for (;;)
+            {
+                auto index = nextFile++;
+                if (index >= options.inputs.size() || threadShouldExit())
+                    return;
+
+                auto& input = options.inputs.getReference (index);
+                auto result = render (input);
+
+                if (result.failed())
+                {
+                    ++numFailures;
+                    printLine ("FAILED " + input.getFullPathName() + ": " + result.getErrorMessage());
+                }
+                else
+                {
+                    printLine ("done   " + input.getFullPathName());
+                }
+            }
+        }
+
+    private:
+        /** Analyses the input and sets the bands that take it towards the reference. */
+        juce::Result match (const juce::File& input, double sampleRate)
+        {
+            auto start = juce::Time::getMillisecondCounterHiRes();
+
+            // the workers share the cores between them
+            auto numThreads = juce::jmax (1, juce::SystemStats::getNumCpus() / juce::jmax (1, options.jobs));
+            MatchEQ::Spectrum spectrum;
+            auto analysed = MatchEQ::analyse (input, formatManager, numThreads, spectrum, [this] { return threadShouldExit(); });
+
+            if (analysed.failed())
+                return analysed;
+
+            auto result = MatchEQ::fit (options.matchSpectrum, spectrum, sampleRate);
+            MatchEQ::apply (result, processor.getParameters());
+
+            printLine ("match  " + input.getFileName() + ": " + juce::String (result.numBands) + " bands, "
+                       + juce::String (result.initialErrorDb, 2) + " -> " + juce::String (result.errorDb, 2) + " dB RMS in "
+                       + juce::String ((juce::Time::getMillisecondCounterHiRes() - start) / 1000.0, 2) + " s");
+
+            return juce::Result::ok();
+        }
+
+        juce::File getOutputFile (const juce::File& input) const
+        {
+            auto extension = options.format.isNotEmpty() ? "." + options.format : input.getFileExtension();
+
+            if (options.outputDir != juce::File())
+                return options.outputDir.getChildFile (input.getFileNameWithoutExtension() + extension);
+
+            return input.getSiblingFile (input.getFileNameWithoutExtension() + "-eq" + extension);
+        }
+
+        juce::Result render (const juce::File& input)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (input));
+            if (reader == nullptr)
+                return juce::Result::fail ("unsupported file");
+
+            auto output = getOutputFile (input);
+            auto* format = formatManager.findFormatForFileExtension (output.getFileExtension());
+            if (format == nullptr)
+                return juce::Result::fail ("unsupported output format " + output.getFileExtension());
+
+            auto numChannels = (int) reader->numChannels;
+            auto sampleRate = reader->sampleRate;
+            auto blockSize = options.blockSize;
+
+            if (options.matchReference != juce::File())
+            {
+                auto matched = match (input, sampleRate);
+                if (matched.failed())
+                    return matched;
+            }
+
+            // only the main buses change; the sidechain stays as it is (disconnected)
+            auto layout = processor.getBusesLayout();
+            layout.getChannelSet (true, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+            layout.getChannelSet (false, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+            if (! processor.setBusesLayout (layout))
+                return juce::Result::fail (juce::String (numChannels) + " channel layout not supported");
+
+            auto bitDepth = (int) reader->bitsPerSample;
+            if (! format->getPossibleBitDepths().contains (bitDepth))
+                bitDepth = 24;
+
+            output.deleteFile();
+            std::unique_ptr<juce::OutputStream> stream (output.createOutputStream());
+            if (stream == nullptr)
+                return juce::Result::fail ("couldn't create " + output.getFullPathName());
+
+            std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels,
+                                                                                      bitDepth, reader->metadataValues, 0));
+            if (writer == nullptr)
+                return juce::Result::fail ("couldn't create writer");
+
+            stream.release(); // the writer owns it now
+
+            processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+            processor.setNonRealtime (true);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            // only ever one block in memory, however long the file is
+            juce::AudioBuffer<float> buffer (numChannels, blockSize);
+            juce::MidiBuffer midi;
+
+            auto latency = (juce::int64) processor.getLatencySamples();
+            auto tail = options.appendTail ? (juce::int64) (processor.getTailLengthSeconds() * sampleRate) : 0;
+            auto totalOut = reader->lengthInSamples + tail;
+            juce::int64 readPos = 0, written = 0;
+
+            while (written < totalOut)
+            {
+                if (threadShouldExit())
+                    return juce::Result::fail ("cancelled");
+
+                // past the end, read() pads with silence, which flushes latency and tail
+                reader->read (&buffer, 0, blockSize, readPos, true, true);
+                readPos += blockSize;
+
+                processor.processBlock (buffer, midi);
+
+                auto start = (int) juce::jlimit ((juce::int64) 0, (juce::int64) blockSize, latency - (readPos - blockSize));
+                auto count = (int) juce::jmin ((juce::int64) (blockSize - start), totalOut - written);
+
+                if (count > 0)
+                {
+                    if (! writer->writeFromAudioSampleBuffer (buffer, start, count))
+                        return juce::Result::fail ("write error");
+
+                    written += count;
+                }
+            }
+
+            if (options.printStats)
+            {
+                // this worker is the render's audio thread, so it can hand over the last counters itself
+                auto& monitor = processor.getPerformanceMonitor();
+                monitor.publish();
+                monitor.update();
+                printLine ("stats  " + input.getFileName() + ": " + monitor.getSnapshot().toString()
+                           + "  " + processor.getDesignCache().getStats().toString());
+            }
+
+            processor.releaseResources();
+            return juce::Result::ok();
+        }
+
+        const Options& options;
+        std::atomic<int>& nextFile;
+        std::atomic<int>& numFailures;
+        juce::AudioFormatManager formatManager;
+        PhaseEQAudioProcessor processor;
+    };
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (juce::CharPointer_UTF8 (argv[i]));
+
+    Options options;
+    auto result = parseArguments (args, options);
+
+    if (result.failed())
+    {
+        std::cerr << result.getErrorMessage() << std::endl
+                  << "usage: PhaseEQRender [--output dir] [--state file] [--param ID=value] [--match file] [--format wav|flac]" << std::endl
+                  << "                     [--block-size n] [--jobs n] [--tail] [--stats] files..." << std::endl;
+        return 1;
+    }
+
+    if (options.outputDir != juce::File())
+        options.outputDir.createDirectory();
+
+    // the reference is the same for every input, so it's only analysed once, with every core
+    if (options.matchReference != juce::File())
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        auto analysed = MatchEQ::analyse (options.matchReference, formatManager, juce::SystemStats::getNumCpus(), options.matchSpectrum);
+        if (analysed.failed())
+        {
+            std::cerr << options.matchReference.getFullPathName() << ": " << analysed.getErrorMessage() << std::endl;
+            return 1;
+        }
+    }
+
+    std::atomic<int> nextFile { 0 }, numFailures { 0 };
+    juce::OwnedArray<RenderWorker> workers;
+
+    // processors are created here, on the message thread, then each one stays on its worker
+    for (int i = 0; i < juce::jmin (options.jobs, options.inputs.size()); ++i)
+    {
+        auto* worker = workers.add (new RenderWorker (options, nextFile, numFailures));
+        auto prepared = worker->prepare();
+
+        if (prepared.failed())
+        {
+            std::cerr << prepared.getErrorMessage() << std::endl;
+            return 1;
+        }
+    }
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit (-1);
+
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+/*
+  ==============================================================================
+
+    FilterCascadeTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/FilterCascade.h"
+
+//==============================================================================
+/**
+    FilterCascade against one juce::dsp::IIR::Filter per section and channel, run
+    on the same coefficients. Both are transposed direct form II in the order JUCE
+    does it, so they only part where the compiler contracts or vectorises the
+    arithmetic differently; the tolerance allows for that and nothing more.
+
+    The mid/side cases switch the first two channels between left/right and
+    mid/side several times, and the reference encodes and decodes them at the
+    same points, running every section in the order it was added.
+*/
+class FilterCascadeTests  : public juce::UnitTest
+{
+public:
+    FilterCascadeTests()  : juce::UnitTest ("FilterCascade", "PhaseEQ") {}
+
+    void runTest() override
+    {
+        using namespace FilterDesign;
+
+        // away from the unit circle, so nothing here needs more than float
+        const Band floatBands[] = { { peak, 250.0, 0.7, 9.0 },      { lowShelf, 400.0, 0.5, -6.0 },
+                                    { notch, 1000.0, 4.0, 0.0 },    { highShelf, 6000.0, 0.7, 4.0 },
+                                    { bandPass, 2500.0, 2.0, 0.0 }, { allPass, 8000.0, 1.0, 0.0 } };
+
+        // and right up to it: 30 Hz at Q 18
+        const Band doubleBands[] = { { peak, 30.0, 18.0, 10.0 },    { lowShelf, 30.0, 0.1, -10.0 },
+                                     { notch, 1000.0, 18.0, 0.0 },  { highShelf, 12000.0, 0.7, 4.0 },
+                                     { allPass, 50.0, 2.0, 0.0 },   { peak, 20000.0, 0.1, -10.0 } };
+
+        for (auto numChannels : { 1, 2, 6 })
+        {
+            // mono takes the scalar loop, the others the SIMD one where there is one
+            auto layout = numChannels == 1 ? juce::String ("mono") : juce::String (numChannels) + " channels";
+
+            beginTest ("float, " + layout);
+            compare<float> (floatBands, 250.0, numChannels, 1.0e-4);
+
+            beginTest ("double, " + layout);
+            compare<double> (doubleBands, 40.0, numChannels, 1.0e-9);
+        }
+
+        for (auto numChannels : { 2, 6 })
+        {
+            auto layout = juce::String (numChannels) + " channels";
+
+            beginTest ("float mid/side, " + layout);
+            compareMidSide<float> (numChannels, 1.0e-4);
+
+            beginTest ("double mid/side, " + layout);
+            compareMidSide<double> (numChannels, 1.0e-9);
+        }
+    }
+
+private:
+    struct Band
+    {
+        int type;
+        double frequency, q, gainDb;
+    };
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int maxBlockSize = 512;
+
+    template <typename SampleType, size_t numBands>
+    void compare (const Band (&bands)[numBands], double slopeFrequency, int numChannels, double tolerance)
+    {
+        using Filter = juce::dsp::IIR::Filter<SampleType>;
+        using Coefficients = juce::dsp::IIR::Coefficients<SampleType>;
+
+        // every band on all channels, then a 48 dB/oct high pass in four sections, then
+        // one more section on the first channel only
+        CascadeSetup setup;
+        setup.sampleRate = sampleRate;
+        int slot = 0;
+
+        for (auto& band : bands)
+            setup.addSection (slot++, FilterDesign::design (band.type, sampleRate, band.frequency, band.q, band.gainDb));
+
+        BiquadCoefficients slope[FilterDesign::maxSlopeSections];
+        auto numSlopeSections = FilterDesign::designSlope (FilterDesign::highPass, FilterDesign::butterworth, 8, sampleRate,
+                                                           slopeFrequency, juce::MathConstants<double>::sqrt2 * 0.5, slope);
+        for (int i = 0; i < numSlopeSections; ++i)
+            setup.addSection (slot++, slope[i]);
+
+        setup.addSection (slot++, FilterDesign::design (FilterDesign::peak, sampleRate, 3000.0, 1.0, -8.0), 1);
+
+        FilterCascade<SampleType> cascade;
+        cascade.prepare ({ sampleRate, (juce::uint32) maxBlockSize, (juce::uint32) numChannels });
+        cascade.setSmoothing (0, 32);
+        cascade.setSetup (setup);
+
+        std::vector<std::vector<Filter>> filters ((size_t) numChannels);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int i = 0; i < setup.numActive; ++i)
+            {
+                auto& c = setup.sections[(size_t) setup.activeSections[(size_t) i]];
+
+                if (((setup.channelMasks[(size_t) setup.activeSections[(size_t) i]] >> ch) & 1) != 0)
+                    filters[(size_t) ch].emplace_back (new Coefficients ((SampleType) c.b0, (SampleType) c.b1, (SampleType) c.b2, 1,
+                                                                         (SampleType) c.a1, (SampleType) c.a2));
+            }
+        }
+
+        juce::AudioBuffer<SampleType> buffer (numChannels, maxBlockSize), expected (numChannels, maxBlockSize);
+        auto& random = getRandom();
+        auto maxError = 0.0;
+
+        // odd block sizes, so the cascade's chunking and the SIMD loops' tails get exercised
+        for (int i = 0; i < 200; ++i)
+        {
+            auto numSamples = 1 + random.nextInt (maxBlockSize);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                for (int n = 0; n < numSamples; ++n)
+                {
+                    auto x = (SampleType) (random.nextDouble() - 0.5);
+                    buffer.setSample (ch, n, x);
+                    expected.setSample (ch, n, x);
+                }
+            }
+
+            juce::dsp::AudioBlock<SampleType> block (buffer.getArrayOfWritePointers(), (size_t) numChannels, (size_t) numSamples);
+            cascade.process (juce::dsp::ProcessContextReplacing<SampleType> (block));
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* data = expected.getWritePointer (ch);
+
+                for (auto& filter : filters[(size_t) ch])
+                    for (int n = 0; n < numSamples; ++n)
+                        data[n] = filter.processSample (data[n]);
+
+                for (int n = 0; n < numSamples; ++n)
+                    maxError = juce::jmax (maxError, (double) std::abs (buffer.getSample (ch, n) - data[n]));
+            }
+        }
+
+        expectLessThan (maxError, tolerance);
+    }
+
+    template <typename SampleType>
+    void compareMidSide (int numChannels, double tolerance)
+    {
+        using namespace FilterDesign;
+        using Filter = juce::dsp::IIR::Filter<SampleType>;
+        using Coefficients = juce::dsp::IIR::Coefficients<SampleType>;
+
+        struct Section
+        {
+            int type;
+            double frequency, q, gainDb;
+            uint64_t mask;
+            bool midSide;
+        };
+
+        // channels 0 and 1 are the pair: mid and side run in 0 and 1 while midSide is set
+        const Section sectionList[] = { { peak, 250.0, 0.7, 6.0, CascadeSetup::allChannels, true },
+                                        { peak, 1000.0, 1.0, 6.0, 1, true },
+                                        { highShelf, 6000.0, 0.7, -4.0, 1, false },
+                                        { lowShelf, 300.0, 0.7, 5.0, 2, true },
+                                        { notch, 3000.0, 4.0, 0.0, CascadeSetup::allChannels, true },
+                                        { peak, 500.0, 2.0, -6.0, 2, false },
+                                        { bandPass, 2000.0, 0.5, 0.0, 3, true } };
+
+        CascadeSetup setup;
+        setup.sampleRate = sampleRate;
+        setup.midSideLeft = 0;
+        setup.midSideRight = 1;
+
+        std::vector<Filter> filters;
+        int slot = 0;
+
+        for (auto& section : sectionList)
+        {
+            auto c = design (section.type, sampleRate, section.frequency, section.q, section.gainDb);
+            setup.addSection (slot, c, section.mask);
+            setup.midSide[(size_t) slot++] = section.midSide;
+
+            // one filter per channel, so each keeps its own state
+            for (int ch = 0; ch < numChannels; ++ch)
+                filters.emplace_back (new Coefficients ((SampleType) c.b0, (SampleType) c.b1, (SampleType) c.b2, 1,
+                                                        (SampleType) c.a1, (SampleType) c.a2));
+        }
+
+        FilterCascade<SampleType> cascade;
+        cascade.prepare ({ sampleRate, (juce::uint32) maxBlockSize, (juce::uint32) numChannels });
+        cascade.setSmoothing (0, 32);
+        cascade.setSetup (setup);
+
+        juce::AudioBuffer<SampleType> buffer (numChannels, maxBlockSize), expected (numChannels, maxBlockSize);
+        auto& random = getRandom();
+        auto maxError = 0.0;
+
+        auto convert = [&] (int numSamples, bool encode)
+        {
+            auto* left = expected.getWritePointer (0);
+            auto* right = expected.getWritePointer (1);
+            auto scale = encode ? (SampleType) 0.5 : (SampleType) 1;
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                auto a = left[n], b = right[n];
+                left[n] = (a + b) * scale;
+                right[n] = (a - b) * scale;
+            }
+        };
+
+        for (int i = 0; i < 200; ++i)
+        {
+            auto numSamples = 1 + random.nextInt (maxBlockSize);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                for (int n = 0; n < numSamples; ++n)
+                {
+                    auto x = (SampleType) (random.nextDouble() - 0.5);
+                    buffer.setSample (ch, n, x);
+                    expected.setSample (ch, n, x);
+                }
+            }
+
+            juce::dsp::AudioBlock<SampleType> block (buffer.getArrayOfWritePointers(), (size_t) numChannels, (size_t) numSamples);
+            cascade.process (juce::dsp::ProcessContextReplacing<SampleType> (block));
+
+            auto inMidSide = false;
+
+            for (size_t k = 0; k < (size_t) juce::numElementsInArray (sectionList); ++k)
+            {
+                if (sectionList[k].midSide != inMidSide)
+                {
+                    inMidSide = ! inMidSide;
+                    convert (numSamples, inMidSide);
+                }
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                {
+                    if (((sectionList[k].mask >> ch) & 1) == 0)
+                        continue;
+
+                    auto* data = expected.getWritePointer (ch);
+                    auto& filter = filters[k * (size_t) numChannels + (size_t) ch];
+
+                    for (int n = 0; n < numSamples; ++n)
+                        data[n] = filter.processSample (data[n]);
+                }
+            }
+
+            if (inMidSide)
+                convert (numSamples, false);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int n = 0; n < numSamples; ++n)
+                    maxError = juce::jmax (maxError, (double) std::abs (buffer.getSample (ch, n) - expected.getSample (ch, n)));
+        }
+
+        expectLessThan (maxError, tolerance);
+    }
+};
+
+static FilterCascadeTests filterCascadeTests;
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    LinearPhaseTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+//==============================================================================
+/**
+    The processor in linear phase mode against a PartitionedConvolver of its own,
+    given the kernel of the setup the processor published and fed the same blocks.
+    Both precisions have to come out as the delayed, filtered input; double goes
+    through the float convolver in chunks, so blocks larger than the one it was
+    prepared for are in there too.
+*/
+class LinearPhaseTests  : public juce::UnitTest
+{
+public:
+    LinearPhaseTests()  : juce::UnitTest ("LinearPhase", "PhaseEQ") {}
+
+    void runTest() override
+    {
+        for (auto numChannels : { 1, 2 })
+        {
+            auto layout = numChannels == 1 ? juce::String ("mono") : juce::String (numChannels) + " channels";
+
+            beginTest ("float, " + layout);
+            compare<float> (numChannels);
+
+            beginTest ("double, " + layout);
+            compare<double> (numChannels);
+        }
+    }
+
+private:
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int preparedBlockSize = 128;
+    static constexpr int maxBlockSize = 512;
+
+    static void setParameter (PhaseEQAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* param = processor.getParameters().getParameter (id))
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    template <typename SampleType>
+    void compare (int numChannels)
+    {
+        using namespace ParameterIDs;
+
+        PhaseEQAudioProcessor processor;
+
+        auto layout = processor.getBusesLayout();
+        layout.getChannelSet (true, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+        layout.getChannelSet (false, 0) = juce::AudioChannelSet::canonicalChannelSet (numChannels);
+
+        if (! processor.setBusesLayout (layout))
+        {
+            expect (false, "unsupported layout");
+            return;
+        }
+
+        // offline, so the kernel is designed before the first block
+        processor.setNonRealtime (true);
+
+        for (int i = 0; i < numBands; ++i)
+            setParameter (processor, band (enabled, i), i == 0 ? 1.f : 0.f);
+
+        setParameter (processor, band (ParameterIDs::type, 0), (float) FilterDesign::peak);
+        setParameter (processor, band (ParameterIDs::freq, 0), 1000.f);
+        setParameter (processor, band (ParameterIDs::q, 0), 2.f);
+        setParameter (processor, band (ParameterIDs::gain, 0), 9.f);
+        setParameter (processor, band (dynamic, 0), 0.f);
+        setParameter (processor, phaseMode, (float) CoefficientDesigner::linearPhase);
+        setParameter (processor, autoGain, 0.f);
+
+        processor.setProcessingPrecision (std::is_same<SampleType, double>::value ? juce::AudioProcessor::doublePrecision
+                                                                                   : juce::AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, preparedBlockSize);
+        processor.prepareToPlay (sampleRate, preparedBlockSize);
+
+        auto& random = getRandom();
+        auto length = 8 * PartitionedConvolver::getLatencySamples (sampleRate);
+        juce::AudioBuffer<SampleType> buffer (numChannels, maxBlockSize);
+        juce::AudioBuffer<float> input (numChannels, length), output (numChannels, length);
+        std::vector<int> blockSizes;
+        juce::MidiBuffer midi;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int n = 0; n < length; ++n)
+                input.setSample (ch, n, (float) (random.nextDouble() - 0.5));
+
+        for (int start = 0; start < length;)
+        {
+            auto numSamples = juce::jmin (length - start, 1 + random.nextInt (maxBlockSize));
+            blockSizes.push_back (numSamples);
+            buffer.setSize (numChannels, numSamples, false, false, true);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int n = 0; n < numSamples; ++n)
+                    buffer.setSample (ch, n, (SampleType) input.getSample (ch, start + n));
+
+            processor.processBlock (buffer, midi);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int n = 0; n < numSamples; ++n)
+                    output.setSample (ch, start + n, (float) buffer.getSample (ch, n));
+
+            start += numSamples;
+        }
+
+        expectEquals (processor.getLatencySamples(), PartitionedConvolver::getLatencySamples (sampleRate));
+
+        // the reference gets its kernel before the first block, as the processor did
+        processor.checkForUpdates();
+        auto kernel = std::make_shared<ConvolutionKernel>();
+        makeLinearPhaseKernel (processor.getGuiSetup(), sampleRate, *kernel);
+
+        PartitionedConvolver reference;
+        reference.prepare ({ sampleRate, (juce::uint32) maxBlockSize, (juce::uint32) numChannels });
+        reference.setKernel (kernel);
+
+        for (int start = 0, i = 0; start < length; start += blockSizes[(size_t) i++])
+        {
+            juce::dsp::AudioBlock<float> block (input.getArrayOfWritePointers(), (size_t) numChannels,
+                                                (size_t) start, (size_t) blockSizes[(size_t) i]);
+            reference.process (juce::dsp::ProcessContextReplacing<float> (block));
+        }
+
+        auto maxError = 0.0, maxOutput = 0.0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            for (int n = 0; n < length; ++n)
+            {
+                maxError = juce::jmax (maxError, (double) std::abs (output.getSample (ch, n) - input.getSample (ch, n)));
+                maxOutput = juce::jmax (maxOutput, (double) std::abs (output.getSample (ch, n)));
+            }
+        }
+
+        expectGreaterThan (maxOutput, 0.1);
+        expectLessThan (maxError, 1.0e-6);
+
+        processor.releaseResources();
+    }
+};
+
+static LinearPhaseTests linearPhaseTests;
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs the juce::UnitTests in the "PhaseEQ" category and exits with 1 if
+    any of them failed, so a build script can treat it like any other test.
+
+    PhaseEQTests [name]
+
+      name                runs only the test of that name (default all)
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure (false);
+
+    if (argc > 1)
+    {
+        juce::Array<juce::UnitTest*> tests;
+        for (auto* test : juce::UnitTest::getTestsInCategory ("PhaseEQ"))
+            if (test->getName() == juce::CharPointer_UTF8 (argv[1]))
+                tests.add (test);
+
+        if (tests.isEmpty())
+        {
+            std::cerr << "no test called " << argv[1] << std::endl;
+            return 1;
+        }
+
+        runner.runTests (tests);
+    }
+    else
+    {
+        runner.runTestsInCategory ("PhaseEQ");
+    }
+
+    int numFailures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        numFailures += runner.getResult (i)->failures;
+
+    return numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+    MidSideTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../Source/PluginProcessor.h"
+
+//==============================================================================
+/**
+    Stereo bands routed to mid, side, left or right, through the whole processor,
+    against a reference that runs one juce::dsp::IIR::Filter per band and channel
+    in band order, encoding to mid/side for each mid or side band and decoding
+    right after it. A left or right only band doesn't commute with the M/S matrix,
+    so any reordering of the bands shows up here.
+*/
+class MidSideTests  : public juce::UnitTest
+{
+public:
+    MidSideTests()  : juce::UnitTest ("MidSide", "PhaseEQ") {}
+
+    void runTest() override
+    {
+        using Designer = CoefficientDesigner;
+        using namespace FilterDesign;
+
+        beginTest ("left only after mid");
+        compare ({ { Designer::mid, peak, 1000.0f, 1.0f, 9.0f },
+                   { Designer::leftOnly, highShelf, 4000.0f, 0.7f, -6.0f } });
+
+        beginTest ("mid after left only");
+        compare ({ { Designer::leftOnly, highShelf, 4000.0f, 0.7f, -6.0f },
+                   { Designer::mid, peak, 1000.0f, 1.0f, 9.0f } });
+
+        beginTest ("side, stereo, right only, mid");
+        compare ({ { Designer::side, lowShelf, 200.0f, 0.7f, 6.0f },
+                   { Designer::stereo, peak, 3000.0f, 2.0f, -4.0f },
+                   { Designer::rightOnly, peak, 600.0f, 1.5f, 8.0f },
+                   { Designer::mid, highShelf, 8000.0f, 0.7f, 5.0f } });
+    }
+
+private:
+    struct Band
+    {
+        int routing, type;
+        float freq, q, gain;
+    };
+
+    static constexpr double sampleRate = 48000.0;
+    static constexpr int blockSize = 512;
+
+    static void setParameter (PhaseEQAudioProcessor& processor, const juce::String& id, float value)
+    {
+        if (auto* param = processor.getParameters().getParameter (id))
+            param->setValueNotifyingHost (param->convertTo0to1 (value));
+    }
+
+    void compare (const std::vector<Band>& bandList)
+    {
+        using namespace ParameterIDs;
+        using Filter = juce::dsp::IIR::Filter<double>;
+        using Coefficients = juce::dsp::IIR::Coefficients<double>;
+
+        PhaseEQAudioProcessor processor;
+
+        auto layout = processor.getBusesLayout();
+        layout.getChannelSet (true, 0) = juce::AudioChannelSet::stereo();
+        layout.getChannelSet (false, 0) = juce::AudioChannelSet::stereo();
+
+        if (! processor.setBusesLayout (layout))
+        {
+            expect (false, "unsupported layout");
+            return;
+        }
+
+        // offline, so every band is designed before the first block
+        processor.setNonRealtime (true);
+
+        for (int i = 0; i < numBands; ++i)
+            setParameter (processor, band (enabled, i), i < (int) bandList.size() ? 1.f : 0.f);
+
+        setParameter (processor, phaseMode, (float) CoefficientDesigner::minimumPhase);
+        setParameter (processor, oversampling, 0.f);
+        setParameter (processor, smoothing, 0.f);
+        setParameter (processor, autoGain, 0.f);
+
+        // the reference is designed from the values the parameters really hold
+        std::vector<std::array<Filter, 2>> filters;
+
+        for (size_t i = 0; i < bandList.size(); ++i)
+        {
+            auto& b = bandList[i];
+            setParameter (processor, band (routing, (int) i), (float) b.routing);
+            setParameter (processor, band (ParameterIDs::type, (int) i), (float) b.type);
+            setParameter (processor, band (freq, (int) i), b.freq);
+            setParameter (processor, band (q, (int) i), b.q);
+            setParameter (processor, band (gain, (int) i), b.gain);
+            setParameter (processor, band (dynamic, (int) i), 0.f);
+
+            auto actual = [&] (const char* id) { return (double) processor.getParameters().getRawParameterValue (band (id, (int) i))->load(); };
+            auto c = FilterDesign::design (b.type, sampleRate, actual (freq), actual (q), actual (gain));
+
+            filters.push_back ({ Filter (new Coefficients (c.b0, c.b1, c.b2, 1.0, c.a1, c.a2)),
+                                 Filter (new Coefficients (c.b0, c.b1, c.b2, 1.0, c.a1, c.a2)) });
+        }
+
+        processor.setProcessingPrecision (juce::AudioProcessor::doublePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        juce::AudioBuffer<double> buffer (2, blockSize), expected (2, blockSize);
+        juce::MidiBuffer midi;
+        auto& random = getRandom();
+        auto maxError = 0.0, maxOutput = 0.0;
+
+        auto convert = [&expected] (bool encode)
+        {
+            auto* left = expected.getWritePointer (0);
+            auto* right = expected.getWritePointer (1);
+            auto scale = encode ? 0.5 : 1.0;
+
+            for (int n = 0; n < blockSize; ++n)
+            {
+                auto l = left[n], r = right[n];
+                left[n] = (l + r) * scale;
+                right[n] = (l - r) * scale;
+            }
+        };
+
+        for (int block = 0; block < 50; ++block)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                for (int n = 0; n < blockSize; ++n)
+                {
+                    auto x = random.nextDouble() - 0.5;
+                    buffer.setSample (ch, n, x);
+                    expected.setSample (ch, n, x);
+                }
+            }
+
+            processor.processBlock (buffer, midi);
+
+            for (size_t i = 0; i < bandList.size(); ++i)
+            {
+                auto r = bandList[i].routing;
+                auto isMidSide = r == CoefficientDesigner::mid || r == CoefficientDesigner::side;
+
+                if (isMidSide)
+                    convert (true);
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    // mid is filtered where left was and side where right was
+                    auto runs = r == CoefficientDesigner::stereo
+                             || (ch == 0 && (r == CoefficientDesigner::leftOnly || r == CoefficientDesigner::mid))
+                             || (ch == 1 && (r == CoefficientDesigner::rightOnly || r == CoefficientDesigner::side));
+
+                    if (! runs)
+                        continue;
+
+                    auto* data = expected.getWritePointer (ch);
+                    for (int n = 0; n < blockSize; ++n)
+                        data[n] = filters[i][(size_t) ch].processSample (data[n]);
+                }
+
+                if (isMidSide)
+                    convert (false);
+            }
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                for (int n = 0; n < blockSize; ++n)
+                {
+                    maxError = juce::jmax (maxError, std::abs (buffer.getSample (ch, n) - expected.getSample (ch, n)));
+                    maxOutput = juce::jmax (maxOutput, std::abs (expected.getSample (ch, n)));
+                }
+            }
+        }
+
+        expectGreaterThan (maxOutput, 0.1);
+        expectLessThan (maxError, 1.0e-9);
+
+        processor.releaseResources();
+    }
+};
+
+static MidSideTests midSideTests;
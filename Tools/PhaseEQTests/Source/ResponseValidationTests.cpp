@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    ResponseValidationTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Common/ResponseValidation.h"
+
+//==============================================================================
+/**
+    The cases of PhaseEQBench --validate with its default options: every type
+    at the corners of FREQ, Q and GAIN, at each common rate, mono and stereo,
+    in both precisions, each within the documented tolerances. There is no
+    baseline here, so a known precision limit is a failure too.
+*/
+class ResponseValidationTests  : public juce::UnitTest
+{
+public:
+    ResponseValidationTests()  : juce::UnitTest ("ResponseValidation", "PhaseEQ") {}
+
+    void runTest() override
+    {
+        PhaseEQAudioProcessor processor;
+        auto filterNames = processor.getFiltersList();
+
+        for (auto doublePrecision : { false, true })
+        {
+            auto tolerances = doublePrecision ? ResponseValidation::doubleTolerances : ResponseValidation::floatTolerances;
+
+            for (auto numChannels : { 1, 2 })
+            {
+                for (auto rate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+                {
+                    beginTest (juce::String (doublePrecision ? "double, " : "float, ") + juce::String (numChannels)
+                                 + (numChannels == 1 ? " channel, " : " channels, ") + juce::String ((int) rate) + " Hz");
+
+                    if (! ResponseValidation::setLayout (processor, numChannels))
+                    {
+                        expect (false, "unsupported layout");
+                        continue;
+                    }
+
+                    for (int type = 0; type < FilterDesign::numFilterTypes; ++type)
+                    {
+                        for (int corner = 0; corner < ResponseValidation::numCorners; ++corner)
+                        {
+                            auto c = ResponseValidation::makeCase (type, rate, numChannels, corner);
+                            auto r = ResponseValidation::validate (processor, c, doublePrecision);
+                            auto failures = ResponseValidation::getFailures (r, tolerances);
+
+                            expect (failures.isEmpty(), filterNames[type] + " at " + juce::String (c.freq) + " Hz, Q "
+                                                          + juce::String (c.q) + ", " + juce::String (c.gain) + " dB: "
+                                                          + failures.joinIntoString ("+") + " (ir " + juce::String (r.irErrorDb, 1)
+                                                          + " dB, sweep " + juce::String (r.sweepErrorDb, 4) + " dB)");
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+static ResponseValidationTests responseValidationTests;